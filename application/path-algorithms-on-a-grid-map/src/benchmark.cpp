@@ -0,0 +1,248 @@
+#include "benchmark.h"
+#include "map/searchworkspace.h"
+#include <chrono>
+#include <random>
+
+Benchmark::Benchmark(MapBase& map, int queriesNumber, unsigned int seed) : _map(map)
+{
+	int verticesNumber = map.GetVerticesNumber();
+	if (verticesNumber <= 0)
+	{
+		return;
+	}
+
+	// Both ends are moveable cells, picked uniformly.
+	std::mt19937 random(seed);
+	std::uniform_int_distribution<int> vertexIds(0, verticesNumber - 1);
+
+	_queries.reserve(queriesNumber);
+	for (int i = 0; i < queriesNumber; i++)
+	{
+		int x1, y1, x2, y2;
+		std::tie(x1, y1) = map.GetVertexCoordinate(vertexIds(random));
+		std::tie(x2, y2) = map.GetVertexCoordinate(vertexIds(random));
+		_queries.push_back(std::make_tuple(x1, y1, x2, y2));
+	}
+}
+
+/// <summary>
+/// Adds variant to measure: setup configures the map (e.g. selects the queue) before its queries run.
+/// </summary>
+void Benchmark::AddVariant(const std::string& name, std::function<void(MapBase&)> setup)
+{
+	_variants.push_back({ name, setup });
+}
+
+/// <summary>
+/// Start cells of the queries, e.g. for preprocessing restricted to the sources of paths.
+/// </summary>
+std::vector<Coordinate> Benchmark::GetQuerySources() const
+{
+	std::vector<Coordinate> sources;
+	sources.reserve(_queries.size());
+	for (const auto& [x1, y1, x2, y2] : _queries)
+	{
+		sources.push_back(std::make_tuple(x1, y1));
+	}
+
+	return sources;
+}
+
+void Benchmark::Run()
+{
+	std::cout << "Benchmark: " << _queries.size() << " queries, " << _variants.size() << " variants." << std::endl;
+
+	// Path costs of the first variant: the rest have to find paths of the same cost.
+	std::vector<int> expectedCosts;
+
+	for (const Variant& variant : _variants)
+	{
+		variant.Setup(_map);
+
+		std::vector<int> costs;
+		costs.reserve(_queries.size());
+
+		long long totalCost = 0;
+		int unreachable = 0;
+
+		// Searches of this thread add their counters here.
+		QueueStatistics& queueStatistics = SearchWorkspace::ForCurrentThread().GetQueueStatistics();
+		SearchStatistics& searchStatistics = SearchWorkspace::ForCurrentThread().GetSearchStatistics();
+		queueStatistics = {};
+		searchStatistics = {};
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		for (const auto& [x1, y1, x2, y2] : _queries)
+		{
+			std::vector<Coordinate> path = _map.GetPath(x1, y1, x2, y2);
+			if (path.empty())
+			{
+				unreachable++;
+				costs.push_back(-1);
+			}
+			else
+			{
+				costs.push_back(_map.GetPathCost(path));
+				totalCost += costs.back();
+			}
+		}
+
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+		// Near optimal variants (e.g. hierarchical search) find longer paths: excess over the cost of the first variant.
+		int mismatches = 0;
+		long long expectedTotalCost = 0;
+		double maxExcess = 0;
+		if (expectedCosts.empty())
+		{
+			expectedCosts = costs;
+		}
+		else
+		{
+			for (size_t i = 0; i < costs.size(); i++)
+			{
+				mismatches += costs[i] != expectedCosts[i];
+
+				if (costs[i] > 0 && expectedCosts[i] > 0)
+				{
+					expectedTotalCost += expectedCosts[i];
+					maxExcess = std::max(maxExcess, (double)(costs[i] - expectedCosts[i]) / expectedCosts[i]);
+				}
+			}
+		}
+
+		std::cout << "  " << variant.Name << ": " << elapsed.count() << " ms, " <<
+			(_queries.empty() ? 0 : elapsed.count() * 1000 / _queries.size()) << " us per query, " <<
+			"total cost " << totalCost << ", unreachable " << unreachable << ", cost mismatches " << mismatches << std::endl;
+
+		if (mismatches > 0 && expectedTotalCost > 0)
+		{
+			std::cout << "    cost excess: " << (double)(totalCost - expectedTotalCost) * 100 / expectedTotalCost << "% in total, " <<
+				maxExcess * 100 << "% at most" << std::endl;
+		}
+
+		if (queueStatistics.Pushes > 0)
+		{
+			std::cout << "    queue: " << queueStatistics.Pushes << " pushes, " << queueStatistics.Pops << " pops, " <<
+				queueStatistics.DecreaseKeys << " decrease-keys" << std::endl;
+		}
+
+		if (searchStatistics.Generated > 0)
+		{
+			std::cout << "    search: " << searchStatistics.Generated << " generated, " << searchStatistics.Expanded << " expanded, " <<
+				searchStatistics.Reexpanded << " re-expanded" << std::endl;
+		}
+
+		if (searchStatistics.Passes > 0)
+		{
+			std::cout << "    passes: " << searchStatistics.Passes << ", " <<
+				(double)searchStatistics.Passes / _queries.size() << " per query, stopped early (a pass relaxed nothing) in " <<
+				searchStatistics.EarlyExits << " of " << _queries.size() << " queries" << std::endl;
+		}
+	}
+}
+
+/// <summary>
+/// Compares path finding variants available for the loaded map. Started instead of the UI when "benchmark" is set in the config.
+/// </summary>
+void RunSearchBenchmark(MapBase& map, int queriesNumber)
+{
+	Benchmark benchmark(map, queriesNumber);
+
+	// Maps with negative cells are searched by Bellman-Ford only: queue-based over the adjacency list or passes over the edge list.
+	if (map.HasNegativeCells())
+	{
+		benchmark.AddVariant("Bellman-Ford, queue (SPFA)", [](MapBase& map) { map.UseEdgeListBellmanFord(false); });
+		benchmark.AddVariant("Bellman-Ford, edge list passes", [](MapBase& map) { map.UseEdgeListBellmanFord(true); });
+
+		benchmark.Run();
+		map.UseEdgeListBellmanFord(false);
+		return;
+	}
+
+	// Queues and heuristics of bidirectional A*. Auto would take Jump Point Search on non-weightened maps, which uses neither.
+	benchmark.AddVariant("Binary heap", [](MapBase& map) {
+		map.UseSearchAlgorithm(SearchAlgorithm::BidirectionalAStar);
+		map.UseSearchQueue(SearchQueueType::BinaryHeap);
+	});
+	benchmark.AddVariant("Indexed 4-ary heap", [](MapBase& map) { map.UseSearchQueue(SearchQueueType::IndexedHeap); });
+	benchmark.AddVariant("Radix heap", [](MapBase& map) { map.UseSearchQueue(SearchQueueType::RadixHeap); });
+	benchmark.AddVariant("Bucket queue (Dial)", [](MapBase& map) { map.UseSearchQueue(SearchQueueType::Buckets); });
+
+	// Heuristics, all with the default queue.
+	benchmark.AddVariant("Manhattan", [](MapBase& map) {
+		map.UseSearchQueue(SearchQueueType::Auto);
+		map.UseSearchHeuristic(SearchHeuristicType::Manhattan);
+	});
+	benchmark.AddVariant("Octile", [](MapBase& map) { map.UseSearchHeuristic(SearchHeuristicType::Octile); });
+	benchmark.AddVariant("Euclidean", [](MapBase& map) { map.UseSearchHeuristic(SearchHeuristicType::Euclidean); });
+	benchmark.AddVariant("Zero (Dijkstra)", [](MapBase& map) { map.UseSearchHeuristic(SearchHeuristicType::Zero); });
+
+	// Unidirectional A* with Manhattan heuristic, runs on non-weightened maps as well.
+	benchmark.AddVariant("A*, binary heap, ties by vertex id", [](MapBase& map) {
+		map.UseSearchHeuristic(SearchHeuristicType::Manhattan);
+		map.UseSearchAlgorithm(SearchAlgorithm::AStar);
+		map.UseSearchQueue(SearchQueueType::BinaryHeap);
+	});
+	benchmark.AddVariant("A*, binary heap, ties to higher g", [](MapBase& map) { map.UseTieBreaking(SearchTieBreaking::HigherG); });
+	benchmark.AddVariant("A*, binary heap, ties in LIFO order", [](MapBase& map) { map.UseTieBreaking(SearchTieBreaking::Lifo); });
+	benchmark.AddVariant("A*, default queue, no tie-breaking", [](MapBase& map) {
+		map.UseTieBreaking(SearchTieBreaking::None);
+		map.UseSearchQueue(SearchQueueType::Auto);
+	});
+	benchmark.AddVariant("A*, default queue, ties to higher g", [](MapBase& map) { map.UseTieBreaking(SearchTieBreaking::HigherG); });
+	benchmark.AddVariant("A*, default queue, ties to higher g, no closed set", [](MapBase& map) { map.UseClosedSet(false); });
+
+	// Hierarchical search against flat A*: time per query and excess cost of its paths. Abstract graphs are built in setup.
+	benchmark.AddVariant("A*", [](MapBase& map) {
+		map.UseTieBreaking(SearchTieBreaking::None);
+		map.UseClosedSet(true);
+	});
+	for (int clusterSize : { 8, 16, 32 })
+	{
+		benchmark.AddVariant("HPA*, clusters " + std::to_string(clusterSize) + "x" + std::to_string(clusterSize), [clusterSize](MapBase& map) {
+			map.UseHierarchicalSearch(clusterSize);
+			map.UseSearchAlgorithm(SearchAlgorithm::Hierarchical);
+		});
+	}
+
+	// ALT against the geometric estimate of the same unidirectional A*. Tables are built (or loaded) in setup.
+	benchmark.AddVariant("A*, Manhattan", [](MapBase& map) {
+		map.UseHierarchicalSearch(0);
+		map.UseSearchAlgorithm(SearchAlgorithm::AStar);
+	});
+	for (LandmarkSelection selection : { LandmarkSelection::Farthest, LandmarkSelection::Avoid })
+	{
+		for (int landmarksNumber : { 8, 16 })
+		{
+			std::string name = "A*, " + std::to_string(landmarksNumber) + " landmarks, " +
+				(selection == LandmarkSelection::Farthest ? "farthest" : "avoid");
+
+			benchmark.AddVariant(name, [landmarksNumber, selection](MapBase& map) {
+				map.UseLandmarks(landmarksNumber, selection);
+				map.UseSearchHeuristic(SearchHeuristicType::Landmarks);
+			});
+		}
+	}
+	benchmark.AddVariant("Bidirectional A*, 16 landmarks, avoid", [](MapBase& map) {
+		map.UseSearchAlgorithm(SearchAlgorithm::BidirectionalAStar);
+	});
+
+	// Contraction hierarchy finds exact paths: no cost mismatches expected. Preprocessing runs in setup.
+	benchmark.AddVariant("Contraction hierarchy", [](MapBase& map) {
+		map.UseLandmarks(0);
+		map.UseContractionHierarchy(true);
+		map.UseSearchAlgorithm(SearchAlgorithm::ContractionHierarchy);
+	});
+
+	// Path database reads paths with no search. Full table takes minutes on large maps, so here it has the rows of the query sources only,
+	// as it would have the rows of the frequent order cells (see MapBase::GetFrequentOrderCells).
+	benchmark.AddVariant("Path database, query sources", [&benchmark](MapBase& map) {
+		map.UseContractionHierarchy(false);
+		map.UsePathDatabase(true, benchmark.GetQuerySources());
+		map.UseSearchAlgorithm(SearchAlgorithm::PathDatabase);
+	});
+
+	benchmark.Run();
+}
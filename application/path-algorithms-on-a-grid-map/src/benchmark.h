@@ -0,0 +1,45 @@
+#ifndef __Benchmark_h__
+#define __Benchmark_h__
+
+#include "common.h"
+#include "map/mapbase.h"
+
+/// <summary>
+/// Measures path finding on the loaded map: runs the same random queries with every variant
+/// and prints time and total path cost of each, so variants are compared on speed and checked for equal results.
+/// </summary>
+class Benchmark
+{
+public:
+	Benchmark(MapBase& map, int queriesNumber, unsigned int seed = 42);
+
+	/// <summary>
+	/// Adds variant to measure: setup configures the map (e.g. selects the queue) before its queries run.
+	/// </summary>
+	void AddVariant(const std::string& name, std::function<void(MapBase&)> setup);
+
+	/// <summary>
+	/// Start cells of the queries, e.g. for preprocessing restricted to the sources of paths.
+	/// </summary>
+	std::vector<Coordinate> GetQuerySources() const;
+
+	void Run();
+
+private:
+	struct Variant
+	{
+		std::string Name;
+		std::function<void(MapBase&)> Setup;
+	};
+
+	MapBase& _map;
+	std::vector<std::tuple<int, int, int, int>> _queries; // x1, y1, x2, y2 of moveable cells.
+	std::vector<Variant> _variants;
+};
+
+/// <summary>
+/// Compares path finding variants available for the loaded map. Started instead of the UI when "benchmark" is set in the config.
+/// </summary>
+void RunSearchBenchmark(MapBase& map, int queriesNumber);
+
+#endif __Benchmark_h__
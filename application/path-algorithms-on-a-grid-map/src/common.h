@@ -28,6 +28,12 @@ const char GRASS_CELL = 'O'; // Imitate positive-weight cells.
 const char WATER_CELL = 'W'; // Imitate negative-weight cells.
 
 
+// Maps with fewer cells are parsed by a single thread: starting workers would cost more than they save.
+const size_t PARALLEL_PARSING_MIN_CELLS = 1 << 20;
+
+// Maps with higher step costs use binary heap instead of Dial's bucket queue: too many buckets to scan.
+const int BUCKET_QUEUE_MAX_WEIGHT = 64;
+
 const int INF = 1e6;
 const int NEG_INF = -1e6;
 const string DEFAULT_ROUTE = "SSSSSSSSSSSSSSSSSSSSSSSSSSSSSSSSSSSSSSSSSSSSSSSSSSSSSSSSSSSS";
@@ -38,6 +44,18 @@ struct AppConfig
     string font;
     string map;
     bool shadow = false;
+    bool implicitGraph = false; // Derive neighbours from the grid instead of building adjacency list.
+    bool compileMap = false; // Save loaded text map as <map>.gridbin and its orders as <map>.orderlog.
+    string orderLog; // Binary order log to replay instead of the orders of the map.
+    int startIteration = 0; // Iteration of the order log to start replay from.
+    bool benchmark = false; // Measure path finding variants on the map instead of starting the UI.
+    int benchmarkQueries = 1000; // Random queries per benchmark variant.
+    int hierarchicalClusterSize = 0; // Find paths with HPA* over clusters of this size, 0 - search the whole grid.
+    bool contractionHierarchy = false; // Preprocess the graph into contraction hierarchy and find paths with it.
+    int landmarks = 0; // Number of ALT landmarks for A* estimates, 0 - geometric estimates only.
+    string landmarkSelection = "farthest"; // How landmarks are picked: "farthest" or "avoid".
+    bool pathDatabase = false; // Read paths from the compressed path database instead of searching them.
+    int pathDatabaseSources = 0; // Sources of the path database: 0 - every moveable cell, N - N most frequent order cells.
 };
 
 #endif
@@ -2,6 +2,10 @@
 #include "screen.h"
 #include "map/navigator.h"
 #include "map/rectangularmap.h"
+#include "map/compiledmap.h"
+#include "map/orderreader.h"
+#include "map/orderlog.h"
+#include "benchmark.h"
 #include <fstream>
 #include <nlohmann/json.hpp>
 
@@ -26,10 +30,31 @@ AppConfig loadConfiguration(const std::string& filename)
 	config.font = jsonData["font"].get<string>();
 	config.map = jsonData["map"].get<string>();
 	config.shadow = jsonData["shadow"].get<bool>();
+	config.implicitGraph = jsonData.value("implicitGraph", false);
+	config.compileMap = jsonData.value("compileMap", false);
+	config.orderLog = jsonData.value("orderLog", "");
+	config.startIteration = jsonData.value("startIteration", 0);
+	config.benchmark = jsonData.value("benchmark", false);
+	config.benchmarkQueries = jsonData.value("benchmarkQueries", 1000);
+	config.hierarchicalClusterSize = jsonData.value("hierarchicalClusterSize", 0);
+	config.contractionHierarchy = jsonData.value("contractionHierarchy", false);
+	config.landmarks = jsonData.value("landmarks", 0);
+	config.landmarkSelection = jsonData.value("landmarkSelection", "farthest");
+	config.pathDatabase = jsonData.value("pathDatabase", false);
+	config.pathDatabaseSources = jsonData.value("pathDatabaseSources", 0);
 
 	return config;
 }
 
+// Path database of the frequent order cells needs orders of the loaded map, so it is set up after LoadMap.
+void usePathDatabase(MapBase& map, const AppConfig& config)
+{
+	if (config.pathDatabase)
+	{
+		map.UsePathDatabase(true, config.pathDatabaseSources > 0 ? map.GetFrequentOrderCells(config.pathDatabaseSources) : std::vector<Coordinate>());
+	}
+}
+
 int main(int argc, char** argv)
 {
     // Initialize default window
@@ -83,6 +108,29 @@ int main(int argc, char** argv)
 
 	std::shared_ptr<Focus> focus = std::make_shared<Focus>(0, 0, DEFAULT_HORIZONTAL_CELLS, DEFAULT_VERTICAL_CELLS);
 	std::shared_ptr<MapBase> map = std::make_shared<RectangularMap>(DEFAULT_HORIZONTAL_CELLS, DEFAULT_VERTICAL_CELLS, focus, window);
+	map->UseImplicitGraph(config.implicitGraph);
+	map->UseHierarchicalSearch(config.hierarchicalClusterSize);
+	map->UseContractionHierarchy(config.contractionHierarchy);
+	if (config.landmarks > 0)
+	{
+		map->UseLandmarks(config.landmarks, config.landmarkSelection == "avoid" ? LandmarkSelection::Avoid : LandmarkSelection::Farthest);
+		map->UseSearchHeuristic(SearchHeuristicType::Landmarks);
+	}
+
+	if (config.benchmark)
+	{
+		std::cout << "Load map start..." << std::endl;
+		if (!map->LoadMap(filepath, shadowed))
+		{
+			return 0;
+		}
+		std::cout << "Load map end..." << std::endl;
+
+		usePathDatabase(*map, config);
+		RunSearchBenchmark(*map, config.benchmarkQueries);
+		return 0;
+	}
+
 	std::shared_ptr<Navigator> navigator = std::make_shared<Navigator>();
 
 	// Redraw.
@@ -122,7 +170,22 @@ int main(int argc, char** argv)
 						{
 							skipReRendering = true;
 							std::cout << "Load tasks from file..." << std::endl;
-							if (navigator->LoadTasks(filepath))
+							bool tasksLoaded = false;
+							if (config.orderLog.empty())
+							{
+								tasksLoaded = navigator->LoadTasks(map->GetOrders());
+							}
+							else
+							{
+								// Replay from the binary order log, starting right from the requested iteration.
+								auto orderLog = std::make_unique<OrderLog>();
+								if (orderLog->Open(config.orderLog) && orderLog->Seek(config.startIteration))
+								{
+									tasksLoaded = navigator->LoadTasks(std::move(orderLog));
+								}
+							}
+
+							if (tasksLoaded)
 							{
 								navigator->SetMap(map);
 							}
@@ -140,6 +203,16 @@ int main(int argc, char** argv)
 							}
 							std::cout << "Load map end..." << std::endl;
 
+							usePathDatabase(*map, config);
+
+							if (config.compileMap && !IsCompiledMapFile(filepath))
+							{
+								map->SaveCompiledMap(filepath + COMPILED_MAP_EXTENSION);
+
+								OrderReader orders(map->GetOrders());
+								OrderLog::Write(filepath + ORDER_LOG_EXTENSION, orders);
+							}
+
 							drawProcessing(window, font);
 						}
 					}
@@ -0,0 +1,66 @@
+#ifndef COMPILEDMAP_H
+#define COMPILEDMAP_H
+
+#include <cstdint>
+#include <string>
+
+// Compiled (binary) map format. Text maps in data/maps stay the source of truth: a compiled map is produced
+// from them by MapBase::SaveCompiledMap and opened by LoadMap without any parsing, since all the arrays
+// are used right from the memory mapped file.
+//
+// Layout (every section starts at 8-bytes aligned offset stored in the header):
+//   CompiledMapHeader
+//   symbols        char[width * height]
+//   vertex ids     int32_t[width * height]
+//   costs          int8_t[width * height]
+//   vertex cells   int32_t[verticesNumber]
+//   graph offsets  int32_t[verticesNumber + 1]
+//   graph arcs     GraphArc[arcsNumber]
+//   orders         text of the orders section (T, D and orders) copied from the source map as is
+
+const char COMPILED_MAP_EXTENSION[] = ".gridbin";
+const char COMPILED_MAP_MAGIC[8] = { 'G', 'R', 'I', 'D', 'B', 'I', 'N', '\0' };
+
+// Increase on any change of the layout or of the graph built from the map, old files will be rejected.
+const uint32_t COMPILED_MAP_VERSION = 3;
+
+struct CompiledMapHeader
+{
+	char Magic[8];
+	uint32_t Version;
+
+	// Header of the text map: N, MaxTips, CostC.
+	int32_t MapSize;
+	int32_t MaxTips;
+	int32_t RoverCost;
+
+	int32_t Width;
+	int32_t Height;
+	int32_t VerticesNumber;
+	uint8_t IsWeighten;
+	uint8_t IsNegativeWeighten;
+	uint8_t Reserved[2];
+	uint64_t ArcsNumber;
+
+	uint64_t SymbolsOffset;
+	uint64_t VertexIdsOffset;
+	uint64_t CostsOffset;
+	uint64_t VertexCellsOffset;
+	uint64_t GraphOffsetsOffset;
+	uint64_t GraphArcsOffset;
+	uint64_t OrdersOffset;
+	uint64_t OrdersSize;
+};
+
+/// <summary>
+/// Compiled maps are recognised by the file extension.
+/// </summary>
+inline bool IsCompiledMapFile(const std::string& filepath)
+{
+	std::string extension = COMPILED_MAP_EXTENSION;
+
+	return filepath.size() >= extension.size() &&
+		filepath.compare(filepath.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+#endif
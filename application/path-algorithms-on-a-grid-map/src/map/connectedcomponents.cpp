@@ -0,0 +1,83 @@
+#include "connectedcomponents.h"
+#include <algorithm>
+
+ConnectedComponents::ConnectedComponents()
+{
+}
+
+void ConnectedComponents::Clear()
+{
+	_componentIds.clear();
+	_componentIds.shrink_to_fit();
+	_componentSizes.clear();
+	_componentSizes.shrink_to_fit();
+}
+
+/// <summary>
+/// Root of the vertex tree. Path halving: every visited vertex is hung on its grandparent on the way.
+/// </summary>
+int ConnectedComponents::_Find(std::vector<int32_t>& parents, int vertexId)
+{
+	while (parents[vertexId] != vertexId)
+	{
+		parents[vertexId] = parents[parents[vertexId]];
+		vertexId = parents[vertexId];
+	}
+
+	return vertexId;
+}
+
+/// <summary>
+/// Joins trees of both vertices: the smaller one is hung on the root of the larger one.
+/// </summary>
+void ConnectedComponents::_Union(std::vector<int32_t>& parents, std::vector<int32_t>& sizes, int firstId, int secondId)
+{
+	int firstRoot = _Find(parents, firstId);
+	int secondRoot = _Find(parents, secondId);
+	if (firstRoot == secondRoot)
+	{
+		return;
+	}
+
+	if (sizes[firstRoot] < sizes[secondRoot])
+	{
+		std::swap(firstRoot, secondRoot);
+	}
+
+	parents[secondRoot] = firstRoot;
+	sizes[firstRoot] += sizes[secondRoot];
+}
+
+/// <summary>
+/// Numbers components of the union-find forest from the largest one.
+/// </summary>
+void ConnectedComponents::_Label(std::vector<int32_t>& parents, const std::vector<int32_t>& sizes)
+{
+	int verticesNumber = (int)parents.size();
+
+	std::vector<int32_t> roots;
+	for (int vertexId = 0; vertexId < verticesNumber; vertexId++)
+	{
+		if (parents[vertexId] == vertexId)
+		{
+			roots.push_back(vertexId);
+		}
+	}
+
+	std::stable_sort(roots.begin(), roots.end(), [&](int first, int second) { return sizes[first] > sizes[second]; });
+
+	// Root -> component number. Sizes of the roots are the sizes of their components.
+	std::vector<int32_t> rootComponents(verticesNumber, -1);
+	_componentSizes.resize(roots.size());
+	for (size_t component = 0; component < roots.size(); component++)
+	{
+		rootComponents[roots[component]] = (int32_t)component;
+		_componentSizes[component] = sizes[roots[component]];
+	}
+
+	_componentIds.resize(verticesNumber);
+	for (int vertexId = 0; vertexId < verticesNumber; vertexId++)
+	{
+		_componentIds[vertexId] = rootComponents[_Find(parents, vertexId)];
+	}
+}
@@ -0,0 +1,70 @@
+#ifndef CONNECTEDCOMPONENTS_H
+#define CONNECTEDCOMPONENTS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+/// <summary>
+/// Connected components of the graph, labelled by union-find over its arcs taken as undirected edges:
+/// vertices of different components have no path between them in either direction. Moveable neighbours of the grid
+/// have arcs both ways (except one-way arcs into negative cells), so on maps without negative cells the same component
+/// means reachable as well. Components are numbered from the largest one, so component 0 is the main part of the map.
+/// </summary>
+class ConnectedComponents
+{
+public:
+	ConnectedComponents();
+
+	/// <summary>
+	/// Labels components of the graph (Graph or GridGraph). Almost linear: union by size with path halving.
+	/// </summary>
+	template <typename TGraph>
+	void Build(const TGraph& graph)
+	{
+		int verticesNumber = graph.GetVerticesNumber();
+
+		std::vector<int32_t> parents(verticesNumber);
+		std::vector<int32_t> sizes(verticesNumber, 1);
+		std::iota(parents.begin(), parents.end(), 0);
+
+		for (int fromId = 0; fromId < verticesNumber; fromId++)
+		{
+			graph.ForEachArc(fromId, [&](int toId, int) { _Union(parents, sizes, fromId, toId); });
+		}
+
+		_Label(parents, sizes);
+	}
+
+	void Clear();
+
+	bool IsBuilt() const { return !_componentIds.empty(); }
+	int GetComponentsNumber() const { return (int)_componentSizes.size(); }
+	int GetComponent(int vertexId) const { return _componentIds[vertexId]; }
+	int GetComponentSize(int component) const { return _componentSizes[component]; }
+	size_t GetMemoryUsage() const { return (_componentIds.capacity() + _componentSizes.capacity()) * sizeof(int32_t); }
+
+	/// <summary>
+	/// Both vertices exist and belong to the same component.
+	/// </summary>
+	bool IsConnected(int fromId, int toId) const
+	{
+		return fromId >= 0 && toId >= 0 && _componentIds[fromId] == _componentIds[toId];
+	}
+
+private:
+	static int _Find(std::vector<int32_t>& parents, int vertexId);
+	static void _Union(std::vector<int32_t>& parents, std::vector<int32_t>& sizes, int firstId, int secondId);
+
+	/// <summary>
+	/// Numbers components of the union-find forest from the largest one.
+	/// </summary>
+	void _Label(std::vector<int32_t>& parents, const std::vector<int32_t>& sizes);
+
+private:
+	std::vector<int32_t> _componentIds;
+	std::vector<int32_t> _componentSizes;
+};
+
+#endif
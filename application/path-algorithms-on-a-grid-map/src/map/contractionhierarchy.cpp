@@ -0,0 +1,523 @@
+#include "contractionhierarchy.h"
+#include <stdexcept>
+#include <thread>
+
+namespace
+{
+	/// <summary>
+	/// Calls func(worker, first, last) for ranges of [0, count), every range in its own thread. Small counts run in the calling thread.
+	/// </summary>
+	template <typename TFunc>
+	void RunInParallel(int workersNumber, int count, TFunc&& func)
+	{
+		const int minRange = 64;
+
+		int threadsNumber = std::clamp(count / minRange, 1, workersNumber);
+		if (threadsNumber == 1)
+		{
+			func(0, 0, count);
+			return;
+		}
+
+		std::vector<std::thread> workers;
+		workers.reserve(threadsNumber);
+		for (int i = 0; i < threadsNumber; i++)
+		{
+			int first = (int)((long long)count * i / threadsNumber);
+			int last = (int)((long long)count * (i + 1) / threadsNumber);
+			workers.emplace_back([&func, i, first, last]() { func(i, first, last); });
+		}
+
+		for (auto& worker : workers)
+		{
+			worker.join();
+		}
+	}
+
+	/// <summary>
+	/// Removes the arc to toId from the list of arcs. Order of arcs does not matter.
+	/// </summary>
+	void RemoveArc(std::vector<ContractionArc>& arcs, int toId)
+	{
+		for (size_t i = 0; i < arcs.size(); i++)
+		{
+			if (arcs[i].To == toId)
+			{
+				arcs[i] = arcs.back();
+				arcs.pop_back();
+				return;
+			}
+		}
+	}
+}
+
+ContractionHierarchy::ContractionHierarchy()
+{
+}
+
+void ContractionHierarchy::Clear()
+{
+	_ranks.clear();
+	_ranks.shrink_to_fit();
+	_upwardOffsets.clear();
+	_upwardOffsets.shrink_to_fit();
+	_upwardArcs.clear();
+	_upwardArcs.shrink_to_fit();
+	_downwardOffsets.clear();
+	_downwardOffsets.shrink_to_fit();
+	_downwardArcs.clear();
+	_downwardArcs.shrink_to_fit();
+}
+
+size_t ContractionHierarchy::GetShortcutsNumber() const
+{
+	size_t shortcutsNumber = 0;
+	for (const ContractionArc& arc : _upwardArcs)
+	{
+		shortcutsNumber += arc.Middle >= 0;
+	}
+
+	for (const ContractionArc& arc : _downwardArcs)
+	{
+		shortcutsNumber += arc.Middle >= 0;
+	}
+
+	return shortcutsNumber;
+}
+
+size_t ContractionHierarchy::GetMemoryUsage() const
+{
+	return (_ranks.capacity() + _upwardOffsets.capacity() + _downwardOffsets.capacity()) * sizeof(int32_t) +
+		(_upwardArcs.capacity() + _downwardArcs.capacity()) * sizeof(ContractionArc);
+}
+
+/// <summary>
+/// Contracts vertices in rounds. Every round takes the vertices of lower priority than all their neighbours:
+/// they are independent, so their shortcuts are found in parallel, with witness searches avoiding the whole round.
+/// Then the round is contracted and priorities of its neighbours are recomputed, in parallel again.
+/// </summary>
+void ContractionHierarchy::_Contract(std::vector<std::vector<ContractionArc>>& outArcs, std::vector<std::vector<ContractionArc>>& inArcs)
+{
+	int verticesNumber = (int)outArcs.size();
+
+	// Every worker thread has its own search state, allocated once for the whole contraction.
+	int workersNumber = std::max((int)std::thread::hardware_concurrency(), 1);
+	std::vector<SearchWorkspace> workspaces(workersNumber);
+	std::vector<RadixHeapQueue> queues(workersNumber);
+	std::vector<std::vector<Shortcut>> workerShortcuts(workersNumber);
+
+	_ranks.assign(verticesNumber, -1);
+	std::vector<int> priorities(verticesNumber, 0);
+	std::vector<int> contractedNeighbours(verticesNumber, 0); // Spreads the contraction evenly over the map.
+	std::vector<uint8_t> isInRound(verticesNumber, 0);
+
+	// Priority is the edge difference of the simulated contraction.
+	auto updatePriorities = [&](const std::vector<int>& vertices)
+	{
+		RunInParallel(workersNumber, (int)vertices.size(), [&](int worker, int first, int last)
+		{
+			std::vector<Shortcut>& shortcuts = workerShortcuts[worker];
+
+			for (int i = first; i < last; i++)
+			{
+				int vertexId = vertices[i];
+
+				shortcuts.clear();
+				_FindShortcuts(vertexId, outArcs, inArcs, isInRound, workspaces[worker], queues[worker], shortcuts);
+
+				int removedArcs = (int)(outArcs[vertexId].size() + inArcs[vertexId].size());
+				priorities[vertexId] = (int)shortcuts.size() - removedArcs + contractedNeighbours[vertexId];
+			}
+		});
+	};
+
+	// Ties of priority are broken by a hash of the vertex id: neighbours with equal priorities do not wait for each other along the rows.
+	auto isLess = [&](int a, int b)
+	{
+		return priorities[a] != priorities[b] ? priorities[a] < priorities[b] : (uint32_t)a * 2654435761u < (uint32_t)b * 2654435761u;
+	};
+
+	std::vector<int> remaining(verticesNumber);
+	for (int vertexId = 0; vertexId < verticesNumber; vertexId++)
+	{
+		remaining[vertexId] = vertexId;
+	}
+
+	updatePriorities(remaining);
+
+	std::vector<int> round;
+	std::vector<std::vector<Shortcut>> roundShortcuts;
+	std::vector<int> neighbours;
+	std::vector<int> lastContractedNeighbour(verticesNumber, -1);
+	std::vector<int> lastRound(verticesNumber, -1);
+	int rank = 0;
+
+	for (int roundIndex = 0; !remaining.empty(); roundIndex++)
+	{
+		// 1. Independent set of the local minimums of priority.
+		round.clear();
+		for (int vertexId : remaining)
+		{
+			bool isMinimum = true;
+			for (const ContractionArc& arc : outArcs[vertexId])
+			{
+				isMinimum = isMinimum && isLess(vertexId, arc.To);
+			}
+
+			for (const ContractionArc& arc : inArcs[vertexId])
+			{
+				isMinimum = isMinimum && isLess(vertexId, arc.To);
+			}
+
+			if (isMinimum)
+			{
+				round.push_back(vertexId);
+				isInRound[vertexId] = 1;
+			}
+		}
+
+		// 2. Shortcuts of the round. Witnesses avoid all its vertices: contracting them one by one could remove
+		// the witness of one vertex while contracting another.
+		roundShortcuts.resize(round.size());
+		RunInParallel(workersNumber, (int)round.size(), [&](int worker, int first, int last)
+		{
+			for (int i = first; i < last; i++)
+			{
+				roundShortcuts[i].clear();
+				_FindShortcuts(round[i], outArcs, inArcs, isInRound, workspaces[worker], queues[worker], roundShortcuts[i]);
+			}
+		});
+
+		// 3. Contraction. Arcs of a contracted vertex stay as they are: all of them lead to vertices contracted later.
+		neighbours.clear();
+		for (size_t i = 0; i < round.size(); i++)
+		{
+			int vertexId = round[i];
+			_ranks[vertexId] = rank++;
+			isInRound[vertexId] = 0;
+
+			auto detach = [&](int neighbourId)
+			{
+				if (lastContractedNeighbour[neighbourId] == vertexId)
+				{
+					return;
+				}
+
+				lastContractedNeighbour[neighbourId] = vertexId;
+				contractedNeighbours[neighbourId]++;
+
+				if (lastRound[neighbourId] != roundIndex)
+				{
+					lastRound[neighbourId] = roundIndex;
+					neighbours.push_back(neighbourId);
+				}
+			};
+
+			for (const ContractionArc& arc : outArcs[vertexId])
+			{
+				RemoveArc(inArcs[arc.To], vertexId);
+				detach(arc.To);
+			}
+
+			for (const ContractionArc& arc : inArcs[vertexId])
+			{
+				RemoveArc(outArcs[arc.To], vertexId);
+				detach(arc.To);
+			}
+
+			for (const Shortcut& shortcut : roundShortcuts[i])
+			{
+				_AddArc(outArcs, inArcs, shortcut.From, shortcut.To, shortcut.Weight, vertexId);
+			}
+		}
+
+		// 4. Neighbours of the round lost arcs and got shortcuts.
+		updatePriorities(neighbours);
+
+		remaining.erase(std::remove_if(remaining.begin(), remaining.end(), [&](int vertexId) { return _ranks[vertexId] >= 0; }), remaining.end());
+	}
+
+	// 5. Hierarchy in CSR form: remaining arcs of every vertex lead upward.
+	auto pack = [&](std::vector<std::vector<ContractionArc>>& arcs, std::vector<int32_t>& offsets, std::vector<ContractionArc>& packed)
+	{
+		offsets.assign(verticesNumber + 1, 0);
+		for (int vertexId = 0; vertexId < verticesNumber; vertexId++)
+		{
+			offsets[vertexId + 1] = offsets[vertexId] + (int32_t)arcs[vertexId].size();
+		}
+
+		packed.clear();
+		packed.reserve(offsets[verticesNumber]);
+		for (int vertexId = 0; vertexId < verticesNumber; vertexId++)
+		{
+			packed.insert(packed.end(), arcs[vertexId].begin(), arcs[vertexId].end());
+			arcs[vertexId] = {};
+		}
+	};
+
+	pack(outArcs, _upwardOffsets, _upwardArcs);
+	pack(inArcs, _downwardOffsets, _downwardArcs);
+}
+
+/// <summary>
+/// Shortcuts needed to contract the vertex. Witness search from every incoming neighbour is limited by the longest path
+/// via the vertex and by CONTRACTION_WITNESS_SETTLED_LIMIT.
+/// </summary>
+void ContractionHierarchy::_FindShortcuts(int vertexId, const std::vector<std::vector<ContractionArc>>& outArcs,
+	const std::vector<std::vector<ContractionArc>>& inArcs, const std::vector<uint8_t>& isExcluded,
+	SearchWorkspace& workspace, RadixHeapQueue& q, std::vector<Shortcut>& shortcuts) const
+{
+	int verticesNumber = (int)outArcs.size();
+
+	int maxOutWeight = 0;
+	for (const ContractionArc& arc : outArcs[vertexId])
+	{
+		maxOutWeight = std::max(maxOutWeight, arc.Weight);
+	}
+
+	for (const ContractionArc& inArc : inArcs[vertexId])
+	{
+		int fromId = inArc.To;
+		int maxDistance = inArc.Weight + maxOutWeight;
+
+		workspace.Begin(verticesNumber);
+		q.Reset(verticesNumber, INF);
+
+		workspace.Visit(fromId, 0, -1);
+		q.Update(0, fromId);
+
+		int settled = 0;
+		while (!q.IsEmpty() && q.GetTopKey() <= maxDistance && settled < CONTRACTION_WITNESS_SETTLED_LIMIT)
+		{
+			int distance = q.GetTopKey();
+			int currentId = q.Pop();
+
+			if (workspace.GetDistance(currentId) < distance)
+			{
+				continue; // Outdated item, vertex was reached cheaper later.
+			}
+
+			settled++;
+
+			for (const ContractionArc& arc : outArcs[currentId])
+			{
+				if (arc.To == vertexId || isExcluded[arc.To])
+				{
+					continue;
+				}
+
+				int newDistance = distance + arc.Weight;
+				if (newDistance <= maxDistance && workspace.GetDistance(arc.To) > newDistance)
+				{
+					workspace.Visit(arc.To, newDistance, currentId);
+					q.Update(newDistance, arc.To);
+				}
+			}
+		}
+
+		// Tentative distances are lengths of real paths as well, so they are witnesses too.
+		for (const ContractionArc& outArc : outArcs[vertexId])
+		{
+			int viaDistance = inArc.Weight + outArc.Weight;
+			if (outArc.To != fromId && workspace.GetDistance(outArc.To) > viaDistance)
+			{
+				shortcuts.push_back({ fromId, outArc.To, viaDistance });
+			}
+		}
+	}
+}
+
+void ContractionHierarchy::_AddArc(std::vector<std::vector<ContractionArc>>& outArcs, std::vector<std::vector<ContractionArc>>& inArcs,
+	int fromId, int toId, int weight, int middle)
+{
+	for (ContractionArc& arc : outArcs[fromId])
+	{
+		if (arc.To != toId)
+		{
+			continue;
+		}
+
+		if (weight < arc.Weight)
+		{
+			arc = { toId, weight, middle };
+			for (ContractionArc& reverseArc : inArcs[toId])
+			{
+				if (reverseArc.To == fromId)
+				{
+					reverseArc = { fromId, weight, middle };
+					break;
+				}
+			}
+		}
+
+		return;
+	}
+
+	outArcs[fromId].push_back({ toId, weight, middle });
+	inArcs[toId].push_back({ fromId, weight, middle });
+}
+
+/// <summary>
+/// Bidirectional Dijkstra over the upward arcs from the start and the downward arcs from the finish.
+/// Vertices reached cheaper from a higher neighbour are stalled: no shortest path goes up through them.
+/// </summary>
+std::vector<int> ContractionHierarchy::FindPath(int startId, int finishId, SearchWorkspace& workspace) const
+{
+	if (!IsBuilt() || startId < 0 || finishId < 0)
+	{
+		return {};
+	}
+
+	int verticesNumber = (int)_ranks.size();
+	workspace.Begin(verticesNumber, 2);
+	SearchStatistics& statistics = workspace.GetSearchStatistics();
+
+	RadixHeapQueue* queues[2] = { &GetQueueForCurrentThread<RadixHeapQueue>(0), &GetQueueForCurrentThread<RadixHeapQueue>(1) };
+	queues[0]->Reset(verticesNumber, INF);
+	queues[1]->Reset(verticesNumber, INF);
+
+	workspace.Visit(startId, 0, -1, 0);
+	workspace.Visit(finishId, 0, -1, 1);
+	queues[0]->Update(0, startId);
+	queues[1]->Update(0, finishId);
+	statistics.Generated += 2;
+
+	int bestDistance = INF;
+	int meetingId = -1;
+
+	while (!queues[0]->IsEmpty() || !queues[1]->IsEmpty())
+	{
+		// The side with the smaller key goes on. Once both keys reach the best distance, no shorter path is left.
+		int side = queues[1]->IsEmpty() || (!queues[0]->IsEmpty() && queues[0]->GetTopKey() <= queues[1]->GetTopKey()) ? 0 : 1;
+		if (queues[side]->GetTopKey() >= bestDistance)
+		{
+			break;
+		}
+
+		int distance = queues[side]->GetTopKey();
+		int currentId = queues[side]->Pop();
+
+		if (workspace.GetDistance(currentId, side) < distance)
+		{
+			continue; // Outdated item, vertex was reached cheaper later.
+		}
+
+		statistics.Expanded++;
+
+		if (workspace.IsVisited(currentId, 1 - side) && distance + workspace.GetDistance(currentId, 1 - side) < bestDistance)
+		{
+			bestDistance = distance + workspace.GetDistance(currentId, 1 - side);
+			meetingId = currentId;
+		}
+
+		// Forward search goes up the upward arcs, so arcs of the other direction come down from higher vertices.
+		const std::vector<int32_t>& offsets = side == 0 ? _upwardOffsets : _downwardOffsets;
+		const std::vector<ContractionArc>& arcs = side == 0 ? _upwardArcs : _downwardArcs;
+		const std::vector<int32_t>& stallOffsets = side == 0 ? _downwardOffsets : _upwardOffsets;
+		const std::vector<ContractionArc>& stallArcs = side == 0 ? _downwardArcs : _upwardArcs;
+
+		bool isStalled = false;
+		for (int i = stallOffsets[currentId]; i < stallOffsets[currentId + 1] && !isStalled; i++)
+		{
+			isStalled = workspace.GetDistance(stallArcs[i].To, side) + stallArcs[i].Weight < distance;
+		}
+
+		if (isStalled)
+		{
+			continue;
+		}
+
+		for (int i = offsets[currentId]; i < offsets[currentId + 1]; i++)
+		{
+			const ContractionArc& arc = arcs[i];
+
+			int newDistance = distance + arc.Weight;
+			if (workspace.GetDistance(arc.To, side) > newDistance)
+			{
+				workspace.Visit(arc.To, newDistance, currentId, side);
+				queues[side]->Update(newDistance, arc.To);
+				statistics.Generated++;
+			}
+		}
+	}
+
+	workspace.GetQueueStatistics() += queues[0]->GetStatistics();
+	workspace.GetQueueStatistics() += queues[1]->GetStatistics();
+
+	if (meetingId == -1)
+	{
+		return {};
+	}
+
+	// Vertices of the hierarchy path: start .. meeting vertex from the forward tree, the rest up to the finish from the backward one.
+	std::vector<int> hierarchyPath;
+	for (int v = meetingId; v != -1; v = workspace.GetPrevious(v, 0))
+	{
+		hierarchyPath.push_back(v);
+	}
+	std::reverse(hierarchyPath.begin(), hierarchyPath.end());
+
+	for (int v = workspace.GetPrevious(meetingId, 1); v != -1; v = workspace.GetPrevious(v, 1))
+	{
+		hierarchyPath.push_back(v);
+	}
+
+	std::vector<int> path = { startId };
+	for (size_t i = 1; i < hierarchyPath.size(); i++)
+	{
+		_UnpackArc(hierarchyPath[i - 1], hierarchyPath[i], path);
+	}
+
+	return path;
+}
+
+const ContractionArc& ContractionHierarchy::_FindArc(int fromId, int toId) const
+{
+	if (_ranks[fromId] < _ranks[toId])
+	{
+		for (int i = _upwardOffsets[fromId]; i < _upwardOffsets[fromId + 1]; i++)
+		{
+			if (_upwardArcs[i].To == toId)
+			{
+				return _upwardArcs[i];
+			}
+		}
+	}
+	else
+	{
+		for (int i = _downwardOffsets[toId]; i < _downwardOffsets[toId + 1]; i++)
+		{
+			if (_downwardArcs[i].To == fromId)
+			{
+				return _downwardArcs[i];
+			}
+		}
+	}
+
+	throw std::logic_error("Arc of the path is missing in the contraction hierarchy.");
+}
+
+/// <summary>
+/// Shortcut fromId -> middle -> toId is replaced by its two arcs, both of them lead to the middle vertex contracted earlier.
+/// </summary>
+void ContractionHierarchy::_UnpackArc(int fromId, int toId, std::vector<int>& path) const
+{
+	// Arcs left to unpack, the next one on top.
+	std::vector<std::pair<int, int>> arcs = { { fromId, toId } };
+
+	while (!arcs.empty())
+	{
+		auto [arcFromId, arcToId] = arcs.back();
+		arcs.pop_back();
+
+		int middle = _FindArc(arcFromId, arcToId).Middle;
+		if (middle < 0)
+		{
+			path.push_back(arcToId);
+			continue;
+		}
+
+		arcs.push_back({ middle, arcToId });
+		arcs.push_back({ arcFromId, middle });
+	}
+}
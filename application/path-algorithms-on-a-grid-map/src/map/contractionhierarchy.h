@@ -0,0 +1,121 @@
+#ifndef CONTRACTIONHIERARCHY_H
+#define CONTRACTIONHIERARCHY_H
+
+#include "graph.h"
+#include "searchqueue.h"
+#include "searchworkspace.h"
+#include <vector>
+
+// Witness searches of the contraction settle this many vertices at most. A witness missed because of the limit
+// only adds a redundant shortcut, paths stay exact.
+const int CONTRACTION_WITNESS_SETTLED_LIMIT = 256;
+
+/// <summary>
+/// Arc of the hierarchy: shortcut for the path via Middle of the same weight, or an arc of the graph (Middle is -1).
+/// </summary>
+struct ContractionArc
+{
+	int32_t To;
+	int32_t Weight;
+	int32_t Middle;
+};
+
+/// <summary>
+/// Contraction hierarchy (CH) for static graphs with non-negative weights.
+/// Preprocessing contracts vertices in the order of their edge difference (shortcuts added minus arcs removed):
+/// a contracted vertex is taken out of the graph, and shortcuts keep the distances between its neighbours
+/// unless a witness path avoiding it is as short. Query runs Dijkstra from both ends over arcs leading to vertices
+/// contracted later only, so it settles a few hundreds of vertices even on large maps. Paths are exact:
+/// shortcuts of the found path are unpacked back into the arcs of the graph.
+/// </summary>
+class ContractionHierarchy
+{
+public:
+	ContractionHierarchy();
+
+	/// <summary>
+	/// Contracts the graph (Graph or GridGraph). Independent vertices are contracted in parallel.
+	/// </summary>
+	template <typename TGraph>
+	void Build(const TGraph& graph)
+	{
+		int verticesNumber = graph.GetVerticesNumber();
+
+		// Arcs of the remaining graph: outgoing and incoming ones of every vertex.
+		std::vector<std::vector<ContractionArc>> outArcs(verticesNumber);
+		std::vector<std::vector<ContractionArc>> inArcs(verticesNumber);
+
+		for (int fromId = 0; fromId < verticesNumber; fromId++)
+		{
+			graph.ForEachArc(fromId, [&](int toId, int weight)
+			{
+				outArcs[fromId].push_back({ toId, weight, -1 });
+				inArcs[toId].push_back({ fromId, weight, -1 });
+			});
+		}
+
+		_Contract(outArcs, inArcs);
+	}
+
+	void Clear();
+
+	bool IsBuilt() const { return !_ranks.empty(); }
+	size_t GetArcsNumber() const { return _upwardArcs.size() + _downwardArcs.size(); }
+	size_t GetShortcutsNumber() const;
+	size_t GetMemoryUsage() const;
+
+	/// <summary>
+	/// Returns vertex ids of every cell of the shortest path, start and finish included, or empty path if the finish is not reachable.
+	/// </summary>
+	std::vector<int> FindPath(int startId, int finishId, SearchWorkspace& workspace) const;
+
+private:
+	/// <summary>
+	/// Shortcut From -> To for the path via the contracted vertex.
+	/// </summary>
+	struct Shortcut
+	{
+		int From;
+		int To;
+		int Weight;
+	};
+
+	void _Contract(std::vector<std::vector<ContractionArc>>& outArcs, std::vector<std::vector<ContractionArc>>& inArcs);
+
+	/// <summary>
+	/// Shortcuts needed to contract the vertex: for every pair of its neighbours without a witness path as short as the one via the vertex.
+	/// Witness searches avoid the vertex and the excluded vertices (contracted along with it).
+	/// </summary>
+	void _FindShortcuts(int vertexId, const std::vector<std::vector<ContractionArc>>& outArcs, const std::vector<std::vector<ContractionArc>>& inArcs,
+		const std::vector<uint8_t>& isExcluded, SearchWorkspace& workspace, RadixHeapQueue& q, std::vector<Shortcut>& shortcuts) const;
+
+	/// <summary>
+	/// Adds the arc to the remaining graph, or makes the existing arc between the same vertices cheaper.
+	/// </summary>
+	static void _AddArc(std::vector<std::vector<ContractionArc>>& outArcs, std::vector<std::vector<ContractionArc>>& inArcs,
+		int fromId, int toId, int weight, int middle);
+
+	/// <summary>
+	/// Arc fromId -> toId of the hierarchy: upward arc of fromId or downward arc of toId, whichever was contracted first.
+	/// </summary>
+	const ContractionArc& _FindArc(int fromId, int toId) const;
+
+	/// <summary>
+	/// Appends cells of the arc fromId -> toId after fromId, up to toId included, unpacking shortcuts recursively.
+	/// </summary>
+	void _UnpackArc(int fromId, int toId, std::vector<int>& path) const;
+
+private:
+	// Order of contraction of every vertex.
+	std::vector<int> _ranks;
+
+	// Arcs of vertex v to vertices of higher rank: _upwardArcs[_upwardOffsets[v] .. _upwardOffsets[v + 1]).
+	std::vector<int32_t> _upwardOffsets;
+	std::vector<ContractionArc> _upwardArcs;
+
+	// Arcs into vertex v from vertices of higher rank (To is the source of the arc), walked by backward searches.
+	std::vector<int32_t> _downwardOffsets;
+	std::vector<ContractionArc> _downwardArcs;
+};
+
+#endif
@@ -1,7 +1,8 @@
 #ifndef COORDINATE_H
 #define COORDINATE_H
 
-#include "cell.h"
+#include "common.h"
+#include <tuple>
 
 typedef std::tuple<int, int> Coordinate;
 
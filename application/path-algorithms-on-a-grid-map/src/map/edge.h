@@ -1,7 +1,7 @@
 #ifndef __Edge_h__
 #define __Edge_h__
 
-#include "cellbase.h"
+#include "common.h"
 
 class Edge
 {
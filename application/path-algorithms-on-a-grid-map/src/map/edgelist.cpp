@@ -0,0 +1,191 @@
+#include "edgelist.h"
+#include <bit>
+
+// AVX2 pass is compiled into every x86-64 build and taken only if the processor has AVX2, so the rest of the program
+// runs anywhere. MSVC takes AVX2 intrinsics without /arch:AVX2, GCC and Clang need the target of the function.
+#if defined(_M_X64) || defined(__x86_64__)
+#define EDGELIST_AVX2
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define EDGELIST_AVX2_TARGET
+#else
+#define EDGELIST_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+#if defined(EDGELIST_AVX2)
+namespace
+{
+	/// <summary>
+	/// Processor has AVX2 and the system saves its registers. Checked once.
+	/// </summary>
+	bool IsAvx2Supported()
+	{
+#if defined(_MSC_VER)
+		static const bool supported = []()
+		{
+			int info[4];
+			__cpuid(info, 0);
+			if (info[0] < 7)
+			{
+				return false;
+			}
+
+			// AVX and OSXSAVE, then YMM state enabled by the system, then AVX2.
+			__cpuid(info, 1);
+			if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0 || (_xgetbv(0) & 6) != 6)
+			{
+				return false;
+			}
+
+			__cpuidex(info, 7, 0);
+			return (info[1] & (1 << 5)) != 0;
+		}();
+#else
+		static const bool supported = __builtin_cpu_supports("avx2");
+#endif
+
+		return supported;
+	}
+}
+#endif
+
+EdgeList::EdgeList() : _verticesNumber(0)
+{
+}
+
+/// <summary>
+/// Copies arcs of the graph in the order of their sources.
+/// </summary>
+void EdgeList::Build(const Graph& graph)
+{
+	Clear();
+
+	_verticesNumber = graph.GetVerticesNumber();
+	_from.Reserve(graph.GetArcsNumber());
+	_to.Reserve(graph.GetArcsNumber());
+	_weights.Reserve(graph.GetArcsNumber());
+
+	for (int fromId = 0; fromId < _verticesNumber; fromId++)
+	{
+		for (const GraphArc& arc : graph[fromId])
+		{
+			_from.PushBack(fromId);
+			_to.PushBack(arc.To);
+			_weights.PushBack(arc.Weight);
+		}
+	}
+}
+
+void EdgeList::Clear()
+{
+	_from.Clear();
+	_from.ShrinkToFit();
+	_to.Clear();
+	_to.ShrinkToFit();
+	_weights.Clear();
+	_weights.ShrinkToFit();
+	_verticesNumber = 0;
+}
+
+/// <summary>
+/// One pass of Bellman-Ford: relaxes every arc going out of a reached vertex (distance below INF),
+/// so distances and previous vertices (GetVerticesNumber() of each) are updated in place.
+/// Returns whether any distance decreased.
+/// </summary>
+bool EdgeList::Relax(int32_t* distances, int32_t* previous) const
+{
+	size_t edgesNumber = _from.GetSize();
+	size_t edgeId = 0;
+	bool relaxed = false;
+
+#if defined(EDGELIST_AVX2)
+	if (IsAvx2Supported())
+	{
+		edgeId = edgesNumber - edgesNumber % 8;
+		relaxed = _RelaxAvx2(0, edgeId, distances, previous);
+	}
+#endif
+
+	// Arcs left after the last full step, or all of them without AVX2.
+	return _RelaxScalar(edgeId, edgesNumber, distances, previous) || relaxed;
+}
+
+#if defined(EDGELIST_AVX2)
+/// <summary>
+/// Relaxes arcs [begin, end) eight at a time, end - begin is a multiple of 8. Only for processors with AVX2.
+/// </summary>
+EDGELIST_AVX2_TARGET bool EdgeList::_RelaxAvx2(size_t begin, size_t end, int32_t* distances, int32_t* previous) const
+{
+	// Distances of sources and targets of eight arcs are gathered at once and compared with a single instruction.
+	// AVX2 has no scatter, and arcs of one step may share the target, so the few improved ones are written back one by one
+	// after the distance is checked again. Distances gathered before the writes are still lengths of real paths,
+	// so the pass only finds less than it could: the next pass takes it up.
+	const __m256i infinity = _mm256_set1_epi32(INF);
+	alignas(32) int32_t newDistances[8];
+	bool relaxed = false;
+
+	for (size_t edgeId = begin; edgeId < end; edgeId += 8)
+	{
+		__m256i from = _mm256_loadu_si256((const __m256i*)(_from.GetData() + edgeId));
+		__m256i to = _mm256_loadu_si256((const __m256i*)(_to.GetData() + edgeId));
+		__m256i weights = _mm256_loadu_si256((const __m256i*)(_weights.GetData() + edgeId));
+
+		__m256i fromDistances = _mm256_i32gather_epi32(distances, from, 4);
+		__m256i toDistances = _mm256_i32gather_epi32(distances, to, 4);
+		__m256i distancesThrough = _mm256_add_epi32(fromDistances, weights);
+
+		__m256i improved = _mm256_and_si256(_mm256_cmpgt_epi32(infinity, fromDistances), _mm256_cmpgt_epi32(toDistances, distancesThrough));
+		uint32_t lanes = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(improved));
+		if (lanes == 0)
+		{
+			continue;
+		}
+
+		_mm256_store_si256((__m256i*)newDistances, distancesThrough);
+		while (lanes != 0)
+		{
+			int lane = std::countr_zero(lanes);
+			lanes &= lanes - 1;
+
+			int toId = _to[edgeId + lane];
+			if (distances[toId] > newDistances[lane])
+			{
+				distances[toId] = newDistances[lane];
+				previous[toId] = _from[edgeId + lane];
+				relaxed = true;
+			}
+		}
+	}
+
+	return relaxed;
+}
+#endif
+
+/// <summary>
+/// Relaxes arcs [begin, end) one by one.
+/// </summary>
+bool EdgeList::_RelaxScalar(size_t begin, size_t end, int32_t* distances, int32_t* previous) const
+{
+	bool relaxed = false;
+	for (size_t edgeId = begin; edgeId < end; edgeId++)
+	{
+		int32_t fromDistance = distances[_from[edgeId]];
+		if (fromDistance >= INF)
+		{
+			continue;
+		}
+
+		int32_t newDistance = fromDistance + _weights[edgeId];
+		int toId = _to[edgeId];
+		if (distances[toId] > newDistance)
+		{
+			distances[toId] = newDistance;
+			previous[toId] = _from[edgeId];
+			relaxed = true;
+		}
+	}
+
+	return relaxed;
+}
@@ -0,0 +1,57 @@
+#ifndef EDGELIST_H
+#define EDGELIST_H
+
+#include "graph.h"
+#include "FlatArray.h"
+#include <cstdint>
+
+/// <summary>
+/// Arcs of the graph as three parallel arrays (structure of arrays): sources, targets and weights.
+/// Bellman-Ford relaxes every arc in every pass, so the arrays are streamed from start to end,
+/// eight arcs per step on processors with AVX2 (see Relax).
+/// </summary>
+class EdgeList
+{
+public:
+	EdgeList();
+
+	/// <summary>
+	/// Copies arcs of the graph in the order of their sources.
+	/// </summary>
+	void Build(const Graph& graph);
+
+	void Clear();
+
+	bool IsBuilt() const { return _from.GetSize() > 0; }
+	int GetVerticesNumber() const { return _verticesNumber; }
+	size_t GetEdgesNumber() const { return _from.GetSize(); }
+	size_t GetMemoryUsage() const { return _from.GetMemoryUsage() + _to.GetMemoryUsage() + _weights.GetMemoryUsage(); }
+
+	/// <summary>
+	/// One pass of Bellman-Ford: relaxes every arc going out of a reached vertex (distance below INF),
+	/// so distances and previous vertices (GetVerticesNumber() of each) are updated in place.
+	/// Returns whether any distance decreased.
+	/// </summary>
+	bool Relax(int32_t* distances, int32_t* previous) const;
+
+private:
+	/// <summary>
+	/// Relaxes arcs [begin, end) eight at a time, end - begin is a multiple of 8. Only for processors with AVX2,
+	/// defined in x86-64 builds only.
+	/// </summary>
+	bool _RelaxAvx2(size_t begin, size_t end, int32_t* distances, int32_t* previous) const;
+
+	/// <summary>
+	/// Relaxes arcs [begin, end) one by one.
+	/// </summary>
+	bool _RelaxScalar(size_t begin, size_t end, int32_t* distances, int32_t* previous) const;
+
+private:
+	FlatArray<int32_t> _from;
+	FlatArray<int32_t> _to;
+	FlatArray<int32_t> _weights;
+
+	int _verticesNumber;
+};
+
+#endif
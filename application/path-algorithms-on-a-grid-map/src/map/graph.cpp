@@ -0,0 +1,99 @@
+#include "graph.h"
+
+Graph::Graph() : _offsets(1, 0), _lastFromId(0)
+{
+}
+
+/// <summary>
+/// Removes all arcs and prepares graph for verticesNumber vertices.
+/// </summary>
+void Graph::Reset(int verticesNumber, size_t expectedArcsNumber)
+{
+	_offsets.Assign(verticesNumber + 1, 0);
+	_arcs.Clear();
+	_arcs.Reserve(expectedArcsNumber);
+	_lastFromId = 0;
+}
+
+/// <summary>
+/// Appends an arc. Arcs have to be added in non-decreasing order of the source vertex.
+/// </summary>
+void Graph::AddArc(int fromId, int toId, int weight)
+{
+	// Close all the vertices between the previous source and this one.
+	while (_lastFromId < fromId)
+	{
+		_offsets.Set(++_lastFromId, (int32_t)_arcs.GetSize());
+	}
+
+	_arcs.PushBack({ toId, weight });
+}
+
+/// <summary>
+/// Completes the offsets array after the last arc is added.
+/// </summary>
+void Graph::Finish()
+{
+	int verticesNumber = GetVerticesNumber();
+
+	while (_lastFromId < verticesNumber)
+	{
+		_offsets.Set(++_lastFromId, (int32_t)_arcs.GetSize());
+	}
+
+	_arcs.ShrinkToFit();
+}
+
+/// <summary>
+/// Uses external CSR arrays (e.g. from the compiled map) instead of own storage.
+/// offsets must have verticesNumber + 1 elements.
+/// </summary>
+void Graph::Attach(int verticesNumber, const int32_t* offsets, const GraphArc* arcs, size_t arcsNumber)
+{
+	_offsets.Attach(offsets, verticesNumber + 1);
+	_arcs.Attach(arcs, arcsNumber);
+	_lastFromId = verticesNumber;
+}
+
+/// <summary>
+/// Builds the graph with all arcs reversed (u -> v with weight w becomes v -> u with weight w) into reversed.
+/// Backward searches walk it from the target.
+/// </summary>
+void Graph::Transpose(Graph& reversed) const
+{
+	int verticesNumber = GetVerticesNumber();
+
+	// Count incoming arcs of every vertex, prefix sum of the counts gives offsets of the reversed graph.
+	std::vector<int32_t> positions(verticesNumber + 1, 0);
+	for (size_t i = 0; i < _arcs.GetSize(); i++)
+	{
+		++positions[_arcs[i].To + 1];
+	}
+
+	for (int v = 0; v < verticesNumber; v++)
+	{
+		positions[v + 1] += positions[v];
+	}
+
+	reversed._offsets.Assign(verticesNumber + 1, 0);
+	for (int v = 0; v <= verticesNumber; v++)
+	{
+		reversed._offsets.Set(v, positions[v]);
+	}
+
+	reversed._arcs.Assign(_arcs.GetSize(), { 0, 0 });
+	for (int fromId = 0; fromId < verticesNumber; fromId++)
+	{
+		for (const GraphArc& arc : (*this)[fromId])
+		{
+			reversed._arcs.Set(positions[arc.To]++, { fromId, arc.Weight });
+		}
+	}
+
+	reversed._lastFromId = verticesNumber;
+}
+
+size_t Graph::GetMemoryUsage() const
+{
+	return _offsets.GetMemoryUsage() + _arcs.GetMemoryUsage();
+}
@@ -1,17 +1,84 @@
 #ifndef GRAPH_H
 #define GRAPH_H
 
-#include "cell.h"
 #include "edge.h"
+#include "FlatArray.h"
+#include <cstdint>
+#include <span>
 
-// We work with a grid. Which is UNORIENTED graph or Cells.
+// We work with a grid. Which is UNORIENTED graph of Cells. Cells themselves live in the Terrain, graph refers to them by vertex id.
 
-// Adjacency list is the best way to represent such a graph.
-typedef std::vector<std::vector<std::shared_ptr<Cell>>> Graph; // Vector[NodeId]->Vector[Neighbour Nodes]
+/// <summary>
+/// Outgoing arc of the vertex: target vertex id and the cost to step into it.
+/// </summary>
+struct GraphArc
+{
+	int32_t To;
+	int32_t Weight;
+};
 
-// For Bellman-Ford, however, we need edges list.
+/// <summary>
+/// Adjacency list packed as CSR (compressed sparse row): arcs of vertex v are
+/// stored contiguously in _arcs[_offsets[v] .. _offsets[v + 1]).
+/// </summary>
+class Graph
+{
+public:
+	Graph();
 
-// Edges list
-typedef std::vector<std::shared_ptr<Edge>> GraphEdgesList; // Vector[NodeId]->Vector[Edges]
+	/// <summary>
+	/// Removes all arcs and prepares graph for verticesNumber vertices.
+	/// </summary>
+	void Reset(int verticesNumber, size_t expectedArcsNumber = 0);
+
+	/// <summary>
+	/// Appends an arc. Arcs have to be added in non-decreasing order of the source vertex.
+	/// </summary>
+	void AddArc(int fromId, int toId, int weight);
+
+	/// <summary>
+	/// Completes the offsets array after the last arc is added.
+	/// </summary>
+	void Finish();
+
+	/// <summary>
+	/// Uses external CSR arrays (e.g. from the compiled map) instead of own storage.
+	/// offsets must have verticesNumber + 1 elements.
+	/// </summary>
+	void Attach(int verticesNumber, const int32_t* offsets, const GraphArc* arcs, size_t arcsNumber);
+
+	/// <summary>
+	/// Builds the graph with all arcs reversed (u -> v with weight w becomes v -> u with weight w) into reversed.
+	/// Backward searches walk it from the target.
+	/// </summary>
+	void Transpose(Graph& reversed) const;
+
+	int GetVerticesNumber() const { return (int)_offsets.GetSize() - 1; }
+	size_t GetArcsNumber() const { return _arcs.GetSize(); }
+	size_t GetMemoryUsage() const;
+
+	std::span<const GraphArc> operator[](int vertexId) const
+	{
+		return std::span<const GraphArc>(_arcs.GetData() + _offsets[vertexId], _arcs.GetData() + _offsets[vertexId + 1]);
+	}
+
+	/// <summary>
+	/// Calls func(toId, weight) for every outgoing arc. Same interface as GridGraph has.
+	/// </summary>
+	template <typename TFunc>
+	void ForEachArc(int vertexId, TFunc&& func) const
+	{
+		for (int i = _offsets[vertexId]; i < _offsets[vertexId + 1]; i++)
+		{
+			func(_arcs[i].To, _arcs[i].Weight);
+		}
+	}
+
+private:
+	FlatArray<int32_t> _offsets;
+	FlatArray<GraphArc> _arcs;
+
+	int _lastFromId;
+};
 
 #endif
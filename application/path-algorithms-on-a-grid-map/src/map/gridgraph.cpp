@@ -0,0 +1,57 @@
+#include "gridgraph.h"
+
+GridGraph::GridGraph() : _terrain(nullptr), _vertexCells(nullptr), _cellOffsets{ 0, 0, 0, 0 }
+{
+}
+
+/// <summary>
+/// Computes passable neighbours mask for every moveable cell. O(cells), no allocations per arc.
+/// </summary>
+void GridGraph::Build(const Terrain& terrain, const FlatArray<int32_t>& vertexCells)
+{
+	_terrain = &terrain;
+	_vertexCells = &vertexCells;
+
+	int width = terrain.GetWidth();
+	int height = terrain.GetHeight();
+
+	for (int direction = 0; direction < DIRECTIONS_NUMBER; direction++)
+	{
+		_cellOffsets[direction] = DIRECTION_ROWS[direction] * width + DIRECTION_COLUMNS[direction];
+	}
+
+	_masks.assign(vertexCells.GetSize(), 0);
+
+	for (size_t vertexId = 0; vertexId < vertexCells.GetSize(); vertexId++)
+	{
+		int cell = vertexCells[vertexId];
+		int row = cell / width;
+		int column = cell - row * width;
+
+		uint8_t mask = 0;
+		for (int direction = 0; direction < DIRECTIONS_NUMBER; direction++)
+		{
+			int r = row + DIRECTION_ROWS[direction];
+			int c = column + DIRECTION_COLUMNS[direction];
+
+			if (r >= 0 && c >= 0 && r < height && c < width &&
+				terrain.GetVertexId(cell + _cellOffsets[direction]) > -1)
+			{
+				mask |= (1 << direction);
+			}
+		}
+
+		_masks[vertexId] = mask;
+	}
+}
+
+void GridGraph::Clear()
+{
+	_masks.clear();
+	_masks.shrink_to_fit();
+}
+
+size_t GridGraph::GetMemoryUsage() const
+{
+	return _masks.capacity() * sizeof(uint8_t);
+}
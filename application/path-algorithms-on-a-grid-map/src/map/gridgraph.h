@@ -0,0 +1,98 @@
+#ifndef GRIDGRAPH_H
+#define GRIDGRAPH_H
+
+#include "terrain.h"
+
+// Directions of a 4-connected grid: Up, Down, Left, Right. Same order as InitialiseGraph uses for the adjacency list.
+constexpr int DIRECTIONS_NUMBER = 4;
+constexpr int DIRECTION_ROWS[DIRECTIONS_NUMBER] = { -1, +1, 0, 0 };
+constexpr int DIRECTION_COLUMNS[DIRECTIONS_NUMBER] = { 0, 0, -1, +1 };
+
+/// <summary>
+/// Implicit graph of a 4-connected grid. Instead of storing arcs, it keeps 4-bit mask of passable neighbours
+/// per vertex and derives neighbours on the fly from the Terrain. Exposes the same ForEachArc() as Graph,
+/// so path finding algorithms can run on both.
+/// Works only for undirected maps, i.e. maps without negative (single-directed) cells.
+/// </summary>
+class GridGraph
+{
+public:
+	GridGraph();
+
+	/// <summary>
+	/// Computes passable neighbours mask for every moveable cell. O(cells), no allocations per arc.
+	/// </summary>
+	void Build(const Terrain& terrain, const FlatArray<int32_t>& vertexCells);
+
+	void Clear();
+
+	int GetVerticesNumber() const { return (int)_masks.size(); }
+	size_t GetMemoryUsage() const;
+
+	template <typename TFunc>
+	void ForEachArc(int vertexId, TFunc&& func) const
+	{
+		int cell = (*_vertexCells)[vertexId];
+		uint8_t mask = _masks[vertexId];
+
+		for (int direction = 0; direction < DIRECTIONS_NUMBER; direction++)
+		{
+			if (mask & (1 << direction))
+			{
+				int toCell = cell + _cellOffsets[direction];
+				func(_terrain->GetVertexId(toCell), _terrain->GetCost(toCell));
+			}
+		}
+	}
+
+	/// <summary>
+	/// Calls func(fromId, weight) for every incoming arc. All arcs into the vertex cost the same: the cost of its cell.
+	/// </summary>
+	template <typename TFunc>
+	void ForEachReverseArc(int vertexId, TFunc&& func) const
+	{
+		int cell = (*_vertexCells)[vertexId];
+		int cost = _terrain->GetCost(cell);
+		uint8_t mask = _masks[vertexId];
+
+		for (int direction = 0; direction < DIRECTIONS_NUMBER; direction++)
+		{
+			if (mask & (1 << direction))
+			{
+				func(_terrain->GetVertexId(cell + _cellOffsets[direction]), cost);
+			}
+		}
+	}
+
+private:
+	const Terrain* _terrain;
+	const FlatArray<int32_t>* _vertexCells;
+
+	// Terrain index offset of the neighbour in each direction.
+	int _cellOffsets[DIRECTIONS_NUMBER];
+
+	// Bit i is set if neighbour in direction i is moveable.
+	std::vector<uint8_t> _masks;
+};
+
+/// <summary>
+/// View of the GridGraph with reversed arcs, for backward searches. Same interface as Graph has.
+/// </summary>
+class ReverseGridGraph
+{
+public:
+	ReverseGridGraph(const GridGraph& graph) : _graph(graph) {}
+
+	int GetVerticesNumber() const { return _graph.GetVerticesNumber(); }
+
+	template <typename TFunc>
+	void ForEachArc(int vertexId, TFunc&& func) const
+	{
+		_graph.ForEachReverseArc(vertexId, func);
+	}
+
+private:
+	const GridGraph& _graph;
+};
+
+#endif
@@ -0,0 +1,525 @@
+#include "hierarchicalsearch.h"
+#include "gridgraph.h"
+#include "searchqueue.h"
+#include <thread>
+
+HierarchicalPath::HierarchicalPath() : _search(nullptr), _nextWaypoint(0), _cost(0)
+{
+}
+
+/// <summary>
+/// Refines the next segment: vertex ids of its cells after the previous waypoint, up to the next waypoint included.
+/// </summary>
+std::vector<int> HierarchicalPath::RefineNextSegment(SearchWorkspace& workspace)
+{
+	if (IsRefined())
+	{
+		return {};
+	}
+
+	int fromId = _waypoints[_nextWaypoint - 1];
+	int toId = _waypoints[_nextWaypoint];
+	_nextWaypoint++;
+
+	return _search->_RefineSegment(fromId, toId, workspace);
+}
+
+HierarchicalSearch::HierarchicalSearch() :
+	_terrain(nullptr),
+	_vertexCells(nullptr),
+	_width(0),
+	_height(0),
+	_clusterSize(0),
+	_clustersPerRow(0),
+	_minWeight(1),
+	_maxWeight(1)
+{
+}
+
+/// <summary>
+/// Finds entrances and computes distances between nodes of every cluster.
+/// O(cells * nodes per cluster): every node runs Dijkstra over its cluster. Clusters are processed by several threads.
+/// </summary>
+void HierarchicalSearch::Build(const Terrain& terrain, const FlatArray<int32_t>& vertexCells, int clusterSize, int minWeight, int maxWeight)
+{
+	_terrain = &terrain;
+	_vertexCells = &vertexCells;
+	_width = terrain.GetWidth();
+	_height = terrain.GetHeight();
+	_clusterSize = clusterSize;
+	_clustersPerRow = (_width + clusterSize - 1) / clusterSize;
+	_minWeight = minWeight;
+	_maxWeight = maxWeight;
+
+	int clustersNumber = _clustersPerRow * ((_height + clusterSize - 1) / clusterSize);
+
+	_nodeVertices.clear();
+	_vertexNodes.assign(vertexCells.GetSize(), -1);
+
+	// Outgoing arcs of every abstract node.
+	std::vector<std::vector<GraphArc>> arcs;
+
+	// 1. Entrances on the borders between left and right clusters, then between upper and lower ones.
+	for (int column = clusterSize; column < _width; column += clusterSize)
+	{
+		for (int top = 0; top < _height; top += clusterSize)
+		{
+			_AddEntrances(top, column - 1, std::min(clusterSize, _height - top), 1, 0, 0, 1, arcs);
+		}
+	}
+
+	for (int row = clusterSize; row < _height; row += clusterSize)
+	{
+		for (int left = 0; left < _width; left += clusterSize)
+		{
+			_AddEntrances(row - 1, left, std::min(clusterSize, _width - left), 0, 1, 1, 0, arcs);
+		}
+	}
+
+	// 2. Nodes grouped by clusters.
+	_clusterNodeOffsets.assign(clustersNumber + 1, 0);
+	for (int vertexId : _nodeVertices)
+	{
+		_clusterNodeOffsets[_GetCluster(vertexId) + 1]++;
+	}
+
+	for (int cluster = 0; cluster < clustersNumber; cluster++)
+	{
+		_clusterNodeOffsets[cluster + 1] += _clusterNodeOffsets[cluster];
+	}
+
+	std::vector<int> positions(_clusterNodeOffsets.begin(), _clusterNodeOffsets.end() - 1);
+	_clusterNodes.resize(_nodeVertices.size());
+	for (int node = 0; node < GetNodesNumber(); node++)
+	{
+		_clusterNodes[positions[_GetCluster(_nodeVertices[node])]++] = node;
+	}
+
+	// 3. Distances between nodes of the same cluster. Every node belongs to one cluster, so threads fill arcs of different nodes.
+	auto connectClusters = [&](int firstCluster, int lastCluster)
+	{
+		SearchWorkspace& workspace = SearchWorkspace::ForCurrentThread();
+
+		for (int cluster = firstCluster; cluster < lastCluster; cluster++)
+		{
+			for (int i = _clusterNodeOffsets[cluster]; i < _clusterNodeOffsets[cluster + 1]; i++)
+			{
+				int fromNode = _clusterNodes[i];
+				_SearchCluster(_nodeVertices[fromNode], -1, false, workspace);
+
+				for (int j = _clusterNodeOffsets[cluster]; j < _clusterNodeOffsets[cluster + 1]; j++)
+				{
+					int toNode = _clusterNodes[j];
+					if (toNode != fromNode && workspace.IsVisited(_nodeVertices[toNode]))
+					{
+						arcs[fromNode].push_back({ toNode, workspace.GetDistance(_nodeVertices[toNode]) });
+					}
+				}
+			}
+		}
+	};
+
+	int threadsNumber = std::clamp((int)std::thread::hardware_concurrency(), 1, std::max(clustersNumber, 1));
+	std::vector<std::thread> workers;
+	workers.reserve(threadsNumber);
+	for (int i = 0; i < threadsNumber; i++)
+	{
+		int firstCluster = (int)((long long)clustersNumber * i / threadsNumber);
+		int lastCluster = (int)((long long)clustersNumber * (i + 1) / threadsNumber);
+		workers.emplace_back(connectClusters, firstCluster, lastCluster);
+	}
+
+	for (auto& worker : workers)
+	{
+		worker.join();
+	}
+
+	// 4. Abstract graph in CSR form.
+	size_t arcsNumber = 0;
+	for (const auto& nodeArcs : arcs)
+	{
+		arcsNumber += nodeArcs.size();
+	}
+
+	_abstractGraph.Reset(GetNodesNumber(), arcsNumber);
+	for (int node = 0; node < GetNodesNumber(); node++)
+	{
+		for (const GraphArc& arc : arcs[node])
+		{
+			_abstractGraph.AddArc(node, arc.To, arc.Weight);
+		}
+	}
+
+	_abstractGraph.Finish();
+}
+
+void HierarchicalSearch::Clear()
+{
+	_nodeVertices.clear();
+	_nodeVertices.shrink_to_fit();
+	_vertexNodes.clear();
+	_vertexNodes.shrink_to_fit();
+	_clusterNodeOffsets.clear();
+	_clusterNodeOffsets.shrink_to_fit();
+	_clusterNodes.clear();
+	_clusterNodes.shrink_to_fit();
+	_abstractGraph.Reset(0);
+	_abstractGraph.Finish();
+	_terrain = nullptr;
+	_vertexCells = nullptr;
+}
+
+size_t HierarchicalSearch::GetMemoryUsage() const
+{
+	return (_nodeVertices.capacity() + _vertexNodes.capacity() + _clusterNodeOffsets.capacity() + _clusterNodes.capacity()) * sizeof(int) +
+		_abstractGraph.GetMemoryUsage();
+}
+
+int HierarchicalSearch::_GetCluster(int vertexId) const
+{
+	int cell = (*_vertexCells)[vertexId];
+	int row = cell / _width;
+	int column = cell - row * _width;
+
+	return (row / _clusterSize) * _clustersPerRow + column / _clusterSize;
+}
+
+/// <summary>
+/// Adds transitions of the border cells with their neighbours across the border. Every maximal run of cells moveable
+/// on both sides is one entrance: short entrances get a transition in the middle, long ones at both ends.
+/// </summary>
+void HierarchicalSearch::_AddEntrances(int row, int column, int length, int stepRow, int stepColumn, int crossRow, int crossColumn,
+	std::vector<std::vector<GraphArc>>& arcs)
+{
+	auto addTransition = [&](int i)
+	{
+		int cell = _terrain->Index(row + i * stepRow, column + i * stepColumn);
+		int crossCell = _terrain->Index(row + i * stepRow + crossRow, column + i * stepColumn + crossColumn);
+
+		int node = _AddNode(_terrain->GetVertexId(cell), arcs);
+		int crossNode = _AddNode(_terrain->GetVertexId(crossCell), arcs);
+
+		// Step costs the cost of the cell it goes into.
+		arcs[node].push_back({ crossNode, _terrain->GetCost(crossCell) });
+		arcs[crossNode].push_back({ node, _terrain->GetCost(cell) });
+	};
+
+	int runStart = -1;
+	for (int i = 0; i <= length; i++)
+	{
+		bool isOpen = false;
+		if (i < length)
+		{
+			int cell = _terrain->Index(row + i * stepRow, column + i * stepColumn);
+			int crossCell = _terrain->Index(row + i * stepRow + crossRow, column + i * stepColumn + crossColumn);
+			isOpen = _terrain->GetVertexId(cell) >= 0 && _terrain->GetVertexId(crossCell) >= 0;
+		}
+
+		if (isOpen && runStart < 0)
+		{
+			runStart = i;
+		}
+		else if (!isOpen && runStart >= 0)
+		{
+			int runLength = i - runStart;
+			if (runLength < HIERARCHICAL_ENTRANCE_SPLIT_LENGTH)
+			{
+				addTransition(runStart + runLength / 2);
+			}
+			else
+			{
+				addTransition(runStart);
+				addTransition(i - 1);
+			}
+
+			runStart = -1;
+		}
+	}
+}
+
+int HierarchicalSearch::_AddNode(int vertexId, std::vector<std::vector<GraphArc>>& arcs)
+{
+	if (_vertexNodes[vertexId] < 0)
+	{
+		_vertexNodes[vertexId] = GetNodesNumber();
+		_nodeVertices.push_back(vertexId);
+		arcs.emplace_back();
+	}
+
+	return _vertexNodes[vertexId];
+}
+
+/// <summary>
+/// Dijkstra from the vertex limited to its cluster. Backward search follows arcs in reverse, so distances are to the vertex.
+/// </summary>
+void HierarchicalSearch::_SearchCluster(int fromId, int toId, bool backward, SearchWorkspace& workspace) const
+{
+	int cell = (*_vertexCells)[fromId];
+	int top = cell / _width / _clusterSize * _clusterSize;
+	int left = cell % _width / _clusterSize * _clusterSize;
+	int bottom = std::min(top + _clusterSize, _height);
+	int right = std::min(left + _clusterSize, _width);
+
+	workspace.Begin((int)_vertexCells->GetSize());
+	SearchStatistics& statistics = workspace.GetSearchStatistics();
+
+	RadixHeapQueue& q = GetQueueForCurrentThread<RadixHeapQueue>();
+	q.Reset((int)_vertexCells->GetSize(), _maxWeight);
+
+	workspace.Visit(fromId, 0, -1);
+	q.Update(0, fromId);
+	statistics.Generated++;
+
+	while (!q.IsEmpty())
+	{
+		int distance = q.GetTopKey();
+		int currentId = q.Pop();
+
+		if (workspace.GetDistance(currentId) < distance)
+		{
+			continue; // Outdated item, vertex was reached cheaper later.
+		}
+
+		if (currentId == toId)
+		{
+			break;
+		}
+
+		statistics.Expanded++;
+
+		int currentCell = (*_vertexCells)[currentId];
+		int row = currentCell / _width;
+		int column = currentCell - row * _width;
+
+		for (int direction = 0; direction < DIRECTIONS_NUMBER; direction++)
+		{
+			int toRow = row + DIRECTION_ROWS[direction];
+			int toColumn = column + DIRECTION_COLUMNS[direction];
+			if (toRow < top || toRow >= bottom || toColumn < left || toColumn >= right)
+			{
+				continue;
+			}
+
+			int toCell = _terrain->Index(toRow, toColumn);
+			int toVertexId = _terrain->GetVertexId(toCell);
+			if (toVertexId < 0)
+			{
+				continue;
+			}
+
+			// Arc u -> v costs the cost of v: backward search walks arc toVertexId -> currentId.
+			int newDistance = distance + _terrain->GetCost(backward ? currentCell : toCell);
+			if (workspace.GetDistance(toVertexId) > newDistance)
+			{
+				workspace.Visit(toVertexId, newDistance, currentId);
+				q.Update(newDistance, toVertexId);
+				statistics.Generated++;
+			}
+		}
+	}
+
+	workspace.GetQueueStatistics() += q.GetStatistics();
+}
+
+/// <summary>
+/// Searches the abstract graph with the start and the finish inserted as temporary nodes.
+/// </summary>
+HierarchicalPath HierarchicalSearch::FindAbstractPath(int x1, int y1, int x2, int y2, SearchWorkspace& workspace) const
+{
+	HierarchicalPath path;
+	path._search = this;
+
+	int startId = _terrain->GetVertexId(_terrain->Index(y1, x1));
+	int finishId = _terrain->GetVertexId(_terrain->Index(y2, x2));
+
+	if (startId < 0 || finishId < 0)
+	{
+		return path;
+	}
+
+	if (startId == finishId)
+	{
+		path._waypoints = { startId };
+		path._nextWaypoint = 1;
+		return path;
+	}
+
+	int nodesNumber = GetNodesNumber();
+	int startNode = nodesNumber;
+	int finishNode = nodesNumber + 1;
+	int startCluster = _GetCluster(startId);
+	int finishCluster = _GetCluster(finishId);
+
+	// Start is connected to the nodes of its cluster (and to the finish, if it is in the same cluster).
+	std::vector<GraphArc> startArcs;
+	_SearchCluster(startId, -1, false, workspace);
+	for (int i = _clusterNodeOffsets[startCluster]; i < _clusterNodeOffsets[startCluster + 1]; i++)
+	{
+		int node = _clusterNodes[i];
+		if (workspace.IsVisited(_nodeVertices[node]))
+		{
+			startArcs.push_back({ node, workspace.GetDistance(_nodeVertices[node]) });
+		}
+	}
+
+	if (startCluster == finishCluster && workspace.IsVisited(finishId))
+	{
+		startArcs.push_back({ finishNode, workspace.GetDistance(finishId) });
+	}
+
+	// Nodes of the finish cluster are connected to the finish: node and the distance from it.
+	std::vector<std::pair<int, int>> finishArcs;
+	_SearchCluster(finishId, -1, true, workspace);
+	for (int i = _clusterNodeOffsets[finishCluster]; i < _clusterNodeOffsets[finishCluster + 1]; i++)
+	{
+		int node = _clusterNodes[i];
+		if (workspace.IsVisited(_nodeVertices[node]))
+		{
+			finishArcs.push_back({ node, workspace.GetDistance(_nodeVertices[node]) });
+		}
+	}
+
+	auto getVertexId = [&](int node)
+	{
+		return node == startNode ? startId : node == finishNode ? finishId : _nodeVertices[node];
+	};
+
+	// Manhattan distance multiplied by the cheapest step cost: abstract arcs are real paths, so it stays consistent.
+	int finishCell = (*_vertexCells)[finishId];
+	int finishRow = finishCell / _width;
+	int finishColumn = finishCell - finishRow * _width;
+	auto calcEuristic = [&](int node)
+	{
+		int cell = (*_vertexCells)[getVertexId(node)];
+		int row = cell / _width;
+		int column = cell - row * _width;
+		return (abs(finishRow - row) + abs(finishColumn - column)) * _minWeight;
+	};
+
+	// A* over the abstract graph.
+	workspace.Begin(nodesNumber + 2);
+	SearchStatistics& statistics = workspace.GetSearchStatistics();
+
+	// Abstract arcs are paths of many steps: radix heap does not limit the step of the keys.
+	RadixHeapQueue& q = GetQueueForCurrentThread<RadixHeapQueue>();
+	q.Reset(nodesNumber + 2, INF);
+
+	workspace.Visit(startNode, 0, -1);
+	q.Update(calcEuristic(startNode), startNode);
+	statistics.Generated++;
+
+	auto relax = [&](int fromNode, int toNode, int weight)
+	{
+		int newDistance = workspace.GetDistance(fromNode) + weight;
+		if (workspace.GetDistance(toNode) > newDistance)
+		{
+			workspace.Visit(toNode, newDistance, fromNode);
+			q.Update(newDistance + calcEuristic(toNode), toNode);
+			statistics.Generated++;
+		}
+	};
+
+	while (!q.IsEmpty())
+	{
+		int priority = q.GetTopKey();
+		int node = q.Pop();
+
+		if (priority > workspace.GetDistance(node) + calcEuristic(node))
+		{
+			continue; // Outdated item, node was reached cheaper later.
+		}
+
+		if (node == finishNode)
+		{
+			break;
+		}
+
+		statistics.Expanded++;
+
+		if (node == startNode)
+		{
+			for (const GraphArc& arc : startArcs)
+			{
+				relax(startNode, arc.To, arc.Weight);
+			}
+
+			continue;
+		}
+
+		_abstractGraph.ForEachArc(node, [&](int toNode, int weight) { relax(node, toNode, weight); });
+
+		if (_GetCluster(_nodeVertices[node]) == finishCluster)
+		{
+			for (const auto& [fromNode, distance] : finishArcs)
+			{
+				if (fromNode == node)
+				{
+					relax(node, finishNode, distance);
+				}
+			}
+		}
+	}
+
+	workspace.GetQueueStatistics() += q.GetStatistics();
+
+	if (!workspace.IsVisited(finishNode))
+	{
+		return path;
+	}
+
+	// Start or finish may be nodes themselves: such waypoints come twice.
+	for (int node = finishNode; node != -1; node = workspace.GetPrevious(node))
+	{
+		int vertexId = getVertexId(node);
+		if (path._waypoints.empty() || path._waypoints.back() != vertexId)
+		{
+			path._waypoints.push_back(vertexId);
+		}
+	}
+
+	std::reverse(path._waypoints.begin(), path._waypoints.end());
+	path._nextWaypoint = 1;
+	path._cost = workspace.GetDistance(finishNode);
+
+	return path;
+}
+
+std::vector<int> HierarchicalSearch::FindPath(int x1, int y1, int x2, int y2, SearchWorkspace& workspace) const
+{
+	HierarchicalPath abstractPath = FindAbstractPath(x1, y1, x2, y2, workspace);
+	if (abstractPath.IsEmpty())
+	{
+		return {};
+	}
+
+	std::vector<int> path = { abstractPath.GetWaypoints()[0] };
+	while (!abstractPath.IsRefined())
+	{
+		std::vector<int> segment = abstractPath.RefineNextSegment(workspace);
+		path.insert(path.end(), segment.begin(), segment.end());
+	}
+
+	return path;
+}
+
+/// <summary>
+/// Cells of the abstract arc: a single step for arcs between clusters, Dijkstra inside the cluster otherwise.
+/// </summary>
+std::vector<int> HierarchicalSearch::_RefineSegment(int fromId, int toId, SearchWorkspace& workspace) const
+{
+	if (_GetCluster(fromId) != _GetCluster(toId))
+	{
+		return { toId };
+	}
+
+	_SearchCluster(fromId, toId, false, workspace);
+
+	std::vector<int> segment;
+	for (int vertexId = toId; vertexId != fromId; vertexId = workspace.GetPrevious(vertexId))
+	{
+		segment.push_back(vertexId);
+	}
+
+	std::reverse(segment.begin(), segment.end());
+	return segment;
+}
@@ -0,0 +1,129 @@
+#ifndef HIERARCHICALSEARCH_H
+#define HIERARCHICALSEARCH_H
+
+#include "graph.h"
+#include "terrain.h"
+#include "searchworkspace.h"
+
+// Entrances shorter than this get one transition in the middle, longer ones get two: at both ends.
+const int HIERARCHICAL_ENTRANCE_SPLIT_LENGTH = 6;
+
+class HierarchicalSearch;
+
+/// <summary>
+/// Path found on the abstract graph of HierarchicalSearch: waypoints (vertex ids) from the start to the finish,
+/// every two consecutive waypoints are either neighbour cells of different clusters or cells of the same cluster.
+/// Segments between waypoints are refined into cells on demand, so only the part of the path about to be driven is searched.
+/// </summary>
+class HierarchicalPath
+{
+public:
+	HierarchicalPath();
+
+	bool IsEmpty() const { return _waypoints.empty(); }
+	bool IsRefined() const { return _nextWaypoint >= _waypoints.size(); }
+
+	const std::vector<int>& GetWaypoints() const { return _waypoints; }
+
+	/// <summary>
+	/// Cost of the path, known before refinement: refined segments cost exactly as their abstract arcs.
+	/// </summary>
+	int GetCost() const { return _cost; }
+
+	/// <summary>
+	/// Refines the next segment: vertex ids of its cells after the previous waypoint, up to the next waypoint included.
+	/// The start is not a part of any segment, it is the first waypoint.
+	/// </summary>
+	std::vector<int> RefineNextSegment(SearchWorkspace& workspace);
+
+private:
+	friend class HierarchicalSearch;
+
+	const HierarchicalSearch* _search;
+	std::vector<int> _waypoints;
+	size_t _nextWaypoint;
+	int _cost;
+};
+
+/// <summary>
+/// Hierarchical path finding (HPA*) for maps without negative cells. The grid is split into square clusters;
+/// for every run of moveable cells along the border of two clusters (entrance) one or two pairs of neighbour cells
+/// become abstract nodes. Abstract graph links nodes of neighbour clusters (one step) and nodes of the same cluster
+/// (shortest path inside the cluster, cached at build time).
+/// Query connects the start and the finish to the nodes of their clusters, runs A* on the small abstract graph
+/// and refines its arcs into cells with searches limited to one cluster. Paths are near optimal: they cross
+/// cluster borders at the transitions only.
+/// </summary>
+class HierarchicalSearch
+{
+public:
+	HierarchicalSearch();
+
+	/// <summary>
+	/// Finds entrances and computes distances between nodes of every cluster. Costs of cells are between minWeight and maxWeight.
+	/// </summary>
+	void Build(const Terrain& terrain, const FlatArray<int32_t>& vertexCells, int clusterSize, int minWeight, int maxWeight);
+
+	void Clear();
+
+	bool IsBuilt() const { return _terrain != nullptr; }
+	int GetClusterSize() const { return _clusterSize; }
+	int GetNodesNumber() const { return (int)_nodeVertices.size(); }
+	size_t GetArcsNumber() const { return _abstractGraph.GetArcsNumber(); }
+	size_t GetMemoryUsage() const;
+
+	/// <summary>
+	/// Searches the abstract graph only. Returns empty path if the finish is not reachable.
+	/// </summary>
+	HierarchicalPath FindAbstractPath(int x1, int y1, int x2, int y2, SearchWorkspace& workspace) const;
+
+	/// <summary>
+	/// Finds abstract path and refines all its segments. Returns vertex ids of every cell of the path,
+	/// start and finish included, or empty path if the finish is not reachable.
+	/// </summary>
+	std::vector<int> FindPath(int x1, int y1, int x2, int y2, SearchWorkspace& workspace) const;
+
+private:
+	friend class HierarchicalPath;
+
+	int _GetCluster(int vertexId) const;
+
+	/// <summary>
+	/// Adds transitions of the border cells (row + i * stepRow, column + i * stepColumn), i in [0, length),
+	/// with their neighbours across the border (crossRow, crossColumn away). Inter-cluster arcs go to arcs.
+	/// </summary>
+	void _AddEntrances(int row, int column, int length, int stepRow, int stepColumn, int crossRow, int crossColumn,
+		std::vector<std::vector<GraphArc>>& arcs);
+
+	int _AddNode(int vertexId, std::vector<std::vector<GraphArc>>& arcs);
+
+	/// <summary>
+	/// Dijkstra from the vertex limited to its cluster. Backward search follows arcs in reverse, so distances are to the vertex.
+	/// Stops at toId if it is set. Distances and previous vertices are left in the workspace.
+	/// </summary>
+	void _SearchCluster(int fromId, int toId, bool backward, SearchWorkspace& workspace) const;
+
+	/// <summary>
+	/// Cells of the abstract arc fromId -> toId after fromId, up to toId included.
+	/// </summary>
+	std::vector<int> _RefineSegment(int fromId, int toId, SearchWorkspace& workspace) const;
+
+private:
+	const Terrain* _terrain;
+	const FlatArray<int32_t>* _vertexCells;
+
+	int _width;
+	int _height;
+	int _clusterSize;
+	int _clustersPerRow;
+	int _minWeight;
+	int _maxWeight;
+
+	std::vector<int> _nodeVertices;       // Abstract node -> vertex id.
+	std::vector<int> _vertexNodes;        // Vertex id -> abstract node, or -1.
+	std::vector<int> _clusterNodeOffsets; // Nodes of cluster c are _clusterNodes[_clusterNodeOffsets[c] .. _clusterNodeOffsets[c + 1]).
+	std::vector<int> _clusterNodes;
+	Graph _abstractGraph;
+};
+
+#endif
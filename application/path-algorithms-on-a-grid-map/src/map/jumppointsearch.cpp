@@ -0,0 +1,495 @@
+#include "jumppointsearch.h"
+#include "gridgraph.h"
+#include <bit>
+#include <cstring>
+#include <queue>
+
+JumpPointSearch::JumpPointSearch() : _terrain(nullptr), _vertexCells(nullptr), _width(0), _height(0), _wordsPerRow(0)
+{
+}
+
+/// <summary>
+/// Packs moveable cells of the terrain into row bitboards. O(cells).
+/// </summary>
+void JumpPointSearch::Build(const Terrain& terrain, const FlatArray<int32_t>& vertexCells)
+{
+	_terrain = &terrain;
+	_vertexCells = &vertexCells;
+	_width = terrain.GetWidth();
+	_height = terrain.GetHeight();
+	_wordsPerRow = (_width + 63) / 64;
+
+	// Extra row above and below the map, so neighbour rows of the border rows need no checks.
+	_rows.assign((size_t)(_height + 2) * _wordsPerRow, 0);
+
+	// Jump distances belong to the previous terrain.
+	_jumpDistances.Clear();
+	_jumpDistancesFile.Close();
+
+	for (size_t vertexId = 0; vertexId < vertexCells.GetSize(); vertexId++)
+	{
+		int cell = vertexCells[vertexId];
+		int row = cell / _width;
+		int column = cell - row * _width;
+
+		_rows[_RowWord(row, column >> 6)] |= (uint64_t)1 << (column & 63);
+	}
+}
+
+void JumpPointSearch::Clear()
+{
+	_rows.clear();
+	_rows.shrink_to_fit();
+	_jumpDistances.Clear();
+	_jumpDistances.ShrinkToFit();
+	_jumpDistancesFile.Close();
+	_terrain = nullptr;
+	_vertexCells = nullptr;
+}
+
+size_t JumpPointSearch::GetMemoryUsage() const
+{
+	return _rows.capacity() * sizeof(uint64_t) + _jumpDistances.GetMemoryUsage();
+}
+
+/// <summary>
+/// JPS+ preprocessing: for every vertex and direction computes the distance to the next jump point (positive),
+/// or, if a block comes first, the number of moveable cells before it (zero or negative). O(cells).
+/// Distance of a cell is derived from the distance of its neighbour in the same direction, so cells are visited
+/// from the far end of the move. Horizontal distances go first: vertical jump points depend on them.
+/// </summary>
+void JumpPointSearch::BuildJumpDistances()
+{
+	// Distances are kept in int16_t.
+	if (_width > INT16_MAX || _height > INT16_MAX)
+	{
+		std::cerr << "Map is too large for jump distances, jumps will scan the rows." << std::endl;
+		return;
+	}
+
+	_jumpDistances.Assign(_vertexCells->GetSize() * DIRECTIONS_NUMBER, 0);
+
+	auto getDistance = [this](int row, int column, int direction)
+	{
+		return (int)_jumpDistances[(size_t)_terrain->GetVertexId(_terrain->Index(row, column)) * DIRECTIONS_NUMBER + direction];
+	};
+
+	// Same jump points as _JumpHorizontally and _JumpVertically find, except the finish.
+	auto isHorizontalJumpPoint = [this](int row, int column, int direction)
+	{
+		int columnDirection = DIRECTION_COLUMNS[direction];
+
+		return (_IsFree(row - 1, column) && !_IsFree(row - 1, column - columnDirection)) ||
+			(_IsFree(row + 1, column) && !_IsFree(row + 1, column - columnDirection));
+	};
+
+	auto isVerticalJumpPoint = [&](int row, int column, int direction)
+	{
+		int rowDirection = DIRECTION_ROWS[direction];
+
+		return (_IsFree(row, column - 1) && !_IsFree(row - rowDirection, column - 1)) ||
+			(_IsFree(row, column + 1) && !_IsFree(row - rowDirection, column + 1)) ||
+			getDistance(row, column, 2) > 0 || getDistance(row, column, 3) > 0;
+	};
+
+	auto setDistance = [&](int row, int column, int direction, auto&& isJumpPoint)
+	{
+		int vertexId = _terrain->GetVertexId(_terrain->Index(row, column));
+		if (vertexId < 0)
+		{
+			return;
+		}
+
+		int nextRow = row + DIRECTION_ROWS[direction];
+		int nextColumn = column + DIRECTION_COLUMNS[direction];
+
+		int distance = 0;
+		if (_IsFree(nextRow, nextColumn))
+		{
+			if (isJumpPoint(nextRow, nextColumn, direction))
+			{
+				distance = 1;
+			}
+			else
+			{
+				int nextDistance = getDistance(nextRow, nextColumn, direction);
+				distance = nextDistance > 0 ? nextDistance + 1 : nextDistance - 1;
+			}
+		}
+
+		_jumpDistances.Set((size_t)vertexId * DIRECTIONS_NUMBER + direction, (int16_t)distance);
+	};
+
+	// Left (2) and Right (3).
+	for (int row = 0; row < _height; row++)
+	{
+		for (int column = 0; column < _width; column++)
+		{
+			setDistance(row, column, 2, isHorizontalJumpPoint);
+		}
+
+		for (int column = _width - 1; column >= 0; column--)
+		{
+			setDistance(row, column, 3, isHorizontalJumpPoint);
+		}
+	}
+
+	// Up (0) and Down (1).
+	for (int row = 0; row < _height; row++)
+	{
+		for (int column = 0; column < _width; column++)
+		{
+			setDistance(row, column, 0, isVerticalJumpPoint);
+		}
+	}
+
+	for (int row = _height - 1; row >= 0; row--)
+	{
+		for (int column = 0; column < _width; column++)
+		{
+			setDistance(row, column, 1, isVerticalJumpPoint);
+		}
+	}
+}
+
+/// <summary>
+/// Writes jump distances into filepath, marked with the terrain hash.
+/// </summary>
+bool JumpPointSearch::SaveJumpDistances(const std::string& filepath, uint64_t terrainHash) const
+{
+	if (!HasJumpDistances())
+	{
+		return false;
+	}
+
+	JumpDistancesHeader header = {};
+	memcpy(header.Magic, JUMP_DISTANCES_MAGIC, sizeof(header.Magic));
+	header.Version = JUMP_DISTANCES_VERSION;
+	header.Width = _width;
+	header.Height = _height;
+	header.VerticesNumber = (int32_t)_vertexCells->GetSize();
+	header.TerrainHash = terrainHash;
+
+	std::ofstream output(filepath, std::ios::binary | std::ios::trunc);
+	if (!output)
+	{
+		std::cerr << "Error opening " << filepath << " for writing." << std::endl;
+		return false;
+	}
+
+	output.write((const char*)&header, sizeof(header));
+	output.write((const char*)_jumpDistances.GetData(), _jumpDistances.GetSize() * sizeof(int16_t));
+
+	if (!output)
+	{
+		std::cerr << "Error writing " << filepath << "." << std::endl;
+		return false;
+	}
+
+	std::cout << "Jump distances saved to " << filepath << " (" << _jumpDistances.GetSize() * sizeof(int16_t) / 1024 << " KB)." << std::endl;
+
+	return true;
+}
+
+/// <summary>
+/// Maps jump distances saved for the same terrain. Fails if there is no file or it was saved for another terrain.
+/// </summary>
+bool JumpPointSearch::LoadJumpDistances(const std::string& filepath, uint64_t terrainHash)
+{
+	_jumpDistances.Clear();
+	_jumpDistancesFile.Close();
+
+	if (!_jumpDistancesFile.Open(filepath))
+	{
+		return false;
+	}
+
+	size_t distancesNumber = _vertexCells->GetSize() * DIRECTIONS_NUMBER;
+	const JumpDistancesHeader* header = (const JumpDistancesHeader*)_jumpDistancesFile.GetData();
+
+	if (_jumpDistancesFile.GetSize() != sizeof(JumpDistancesHeader) + distancesNumber * sizeof(int16_t) ||
+		memcmp(header->Magic, JUMP_DISTANCES_MAGIC, sizeof(header->Magic)) != 0 ||
+		header->Version != JUMP_DISTANCES_VERSION ||
+		header->Width != _width ||
+		header->Height != _height ||
+		header->VerticesNumber != (int32_t)_vertexCells->GetSize() ||
+		header->TerrainHash != terrainHash)
+	{
+		std::cout << filepath << " was saved for another version of the map, jump distances will be computed again." << std::endl;
+		_jumpDistancesFile.Close();
+		return false;
+	}
+
+	_jumpDistances.Attach((const int16_t*)(_jumpDistancesFile.GetData() + sizeof(JumpDistancesHeader)), distancesNumber);
+
+	return true;
+}
+
+/// <summary>
+/// Jumps from (row, column) in direction (-1 or +1) along the row. Returns column of the jump point, or -1.
+/// Takes whole words of the row: stops are blocked cells, the finish and cells with forced neighbours,
+/// i.e. moveable cells above (below) the row which have non-moveable cell before them.
+/// </summary>
+int JumpPointSearch::_JumpHorizontally(int row, int column, int direction, int finishRow, int finishColumn) const
+{
+	int start = column + direction;
+	if (start < 0 || start >= _width)
+	{
+		return -1;
+	}
+
+	const uint64_t* current = &_rows[_RowWord(row, 0)];
+	const uint64_t* above = &_rows[_RowWord(row - 1, 0)];
+	const uint64_t* below = &_rows[_RowWord(row + 1, 0)];
+	int startWord = start >> 6;
+
+	if (direction > 0)
+	{
+		for (int word = startWord; word < _wordsPerRow; word++)
+		{
+			// Bit i of *Before is the cell to the left of bit i, taking the last bit of the previous word.
+			uint64_t aboveBefore = (above[word] << 1) | (word > 0 ? above[word - 1] >> 63 : 0);
+			uint64_t belowBefore = (below[word] << 1) | (word > 0 ? below[word - 1] >> 63 : 0);
+
+			uint64_t stops = (above[word] & ~aboveBefore) | (below[word] & ~belowBefore) | ~current[word];
+			if (row == finishRow && (finishColumn >> 6) == word)
+			{
+				stops |= (uint64_t)1 << (finishColumn & 63);
+			}
+			if (word == startWord)
+			{
+				stops &= ~(uint64_t)0 << (start & 63);
+			}
+
+			if (stops)
+			{
+				int bit = std::countr_zero(stops);
+				return ((current[word] >> bit) & 1) ? word * 64 + bit : -1;
+			}
+		}
+	}
+	else
+	{
+		for (int word = startWord; word >= 0; word--)
+		{
+			// Bit i of *Before is the cell to the right of bit i, taking the first bit of the next word.
+			uint64_t aboveBefore = (above[word] >> 1) | (word + 1 < _wordsPerRow ? above[word + 1] << 63 : 0);
+			uint64_t belowBefore = (below[word] >> 1) | (word + 1 < _wordsPerRow ? below[word + 1] << 63 : 0);
+
+			uint64_t stops = (above[word] & ~aboveBefore) | (below[word] & ~belowBefore) | ~current[word];
+			if (row == finishRow && (finishColumn >> 6) == word)
+			{
+				stops |= (uint64_t)1 << (finishColumn & 63);
+			}
+			if (word == startWord)
+			{
+				stops &= ~(uint64_t)0 >> (63 - (start & 63));
+			}
+
+			if (stops)
+			{
+				int bit = 63 - std::countl_zero(stops);
+				return ((current[word] >> bit) & 1) ? word * 64 + bit : -1;
+			}
+		}
+	}
+
+	return -1;
+}
+
+/// <summary>
+/// Jumps from (row, column) in direction (-1 or +1) along the column. Returns row of the jump point, or -1.
+/// Every cell of the vertical move spawns horizontal jumps: if one of them finds a jump point, the cell is a jump point itself.
+/// </summary>
+int JumpPointSearch::_JumpVertically(int row, int column, int direction, int finishRow, int finishColumn) const
+{
+	// Padding rows stop the move at the map border.
+	for (int r = row + direction; _IsFree(r, column); r += direction)
+	{
+		if (r == finishRow && column == finishColumn)
+		{
+			return r;
+		}
+
+		if ((_IsFree(r, column - 1) && !_IsFree(r - direction, column - 1)) ||
+			(_IsFree(r, column + 1) && !_IsFree(r - direction, column + 1)))
+		{
+			return r;
+		}
+
+		if (_JumpHorizontally(r, column, -1, finishRow, finishColumn) != -1 ||
+			_JumpHorizontally(r, column, +1, finishRow, finishColumn) != -1)
+		{
+			return r;
+		}
+	}
+
+	return -1;
+}
+
+/// <summary>
+/// Same jump as _JumpHorizontally / _JumpVertically in direction (index of DIRECTION_ROWS), taken from the jump distances.
+/// Stops at the finish, and for vertical moves at the row of the finish, where horizontal jumps may reach it.
+/// </summary>
+bool JumpPointSearch::_LookUpJump(int vertexId, int row, int column, int direction, int finishRow, int finishColumn, int& toRow, int& toColumn) const
+{
+	int rowDirection = DIRECTION_ROWS[direction];
+	int columnDirection = DIRECTION_COLUMNS[direction];
+
+	int distance = _jumpDistances[(size_t)vertexId * DIRECTIONS_NUMBER + direction];
+	int reach = abs(distance);
+
+	// Steps to the finish (to its row for vertical moves), positive if it is ahead.
+	int finishSteps = rowDirection != 0 ? (finishRow - row) * rowDirection : (finishColumn - column) * columnDirection;
+	bool isFinishAhead = finishSteps > 0 && finishSteps <= reach && (rowDirection != 0 || row == finishRow);
+
+	int steps = 0;
+	if (isFinishAhead)
+	{
+		steps = finishSteps;
+	}
+	else if (distance > 0)
+	{
+		steps = distance;
+	}
+	else
+	{
+		return false;
+	}
+
+	toRow = row + rowDirection * steps;
+	toColumn = column + columnDirection * steps;
+	return true;
+}
+
+/// <summary>
+/// A* over jump points. Distance between the jump point and its successor is Manhattan distance,
+/// since they always lie on the same row or column; Manhattan distance to the finish is the heuristic.
+/// </summary>
+std::vector<int> JumpPointSearch::FindPath(int x1, int y1, int x2, int y2, SearchWorkspace& workspace) const
+{
+	int startId = _terrain->GetVertexId(_terrain->Index(y1, x1));
+	int finishId = _terrain->GetVertexId(_terrain->Index(y2, x2));
+
+	if (startId < 0 || finishId < 0 || startId == finishId)
+	{
+		return {};
+	}
+
+	workspace.Begin((int)_vertexCells->GetSize());
+	workspace.Visit(startId, 0, -2);
+
+	VisitedSet& closed = workspace.GetVisited(0);
+
+	std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int>>, std::greater<std::pair<int, int>>> open;
+	open.push({ abs(x2 - x1) + abs(y2 - y1), startId });
+
+	while (!open.empty())
+	{
+		int currentId = open.top().second;
+		open.pop();
+
+		if (closed.Test(currentId)) // Защитное условие, т.к. из очереди ничего не удаляется
+		{
+			continue;
+		}
+
+		closed.Set(currentId);
+
+		if (currentId == finishId)
+		{
+			break;
+		}
+
+		int cell = (*_vertexCells)[currentId];
+		int row = cell / _width;
+		int column = cell - row * _width;
+		int distance = workspace.GetDistance(currentId);
+
+		// Direction of the move into the current jump point. Start has none, so it jumps in all 4 directions.
+		int moveRow = 0;
+		int moveColumn = 0;
+		int previousId = workspace.GetPrevious(currentId);
+		if (previousId >= 0)
+		{
+			int previousCell = (*_vertexCells)[previousId];
+			int previousRow = previousCell / _width;
+			moveRow = (row > previousRow) - (row < previousRow);
+			moveColumn = (column > previousCell - previousRow * _width) - (column < previousCell - previousRow * _width);
+		}
+
+		for (int direction = 0; direction < DIRECTIONS_NUMBER; direction++)
+		{
+			int directionRow = DIRECTION_ROWS[direction];
+			int directionColumn = DIRECTION_COLUMNS[direction];
+
+			// Going back never gives a shorter path.
+			if (directionRow == -moveRow && directionColumn == -moveColumn)
+			{
+				continue;
+			}
+
+			int toRow = row;
+			int toColumn = column;
+			if (HasJumpDistances())
+			{
+				if (!_LookUpJump(currentId, row, column, direction, y2, x2, toRow, toColumn))
+				{
+					continue;
+				}
+			}
+			else
+			{
+				if (directionRow != 0)
+				{
+					toRow = _JumpVertically(row, column, directionRow, y2, x2);
+				}
+				else
+				{
+					toColumn = _JumpHorizontally(row, column, directionColumn, y2, x2);
+				}
+
+				if (toRow < 0 || toColumn < 0)
+				{
+					continue;
+				}
+			}
+
+			int toId = _terrain->GetVertexId(_terrain->Index(toRow, toColumn));
+			int toDistance = distance + abs(toRow - row) + abs(toColumn - column);
+
+			if (!closed.Test(toId) && toDistance < workspace.GetDistance(toId))
+			{
+				workspace.Visit(toId, toDistance, currentId);
+				open.push({ toDistance + abs(x2 - toColumn) + abs(y2 - toRow), toId });
+			}
+		}
+	}
+
+	if (!workspace.IsVisited(finishId))
+	{
+		return {};
+	}
+
+	// Jump points are connected by straight segments: restore every cell between them.
+	std::vector<int> path;
+	for (int v = finishId; v != startId; v = workspace.GetPrevious(v))
+	{
+		int cell = (*_vertexCells)[v];
+		int previousCell = (*_vertexCells)[workspace.GetPrevious(v)];
+		int step = (previousCell / _width == cell / _width) ? 1 : _width;
+		if (previousCell < cell)
+		{
+			step = -step;
+		}
+
+		for (; cell != previousCell; cell += step)
+		{
+			path.push_back(_terrain->GetVertexId(cell));
+		}
+	}
+	path.push_back(startId);
+
+	std::reverse(path.begin(), path.end());
+	return path;
+}
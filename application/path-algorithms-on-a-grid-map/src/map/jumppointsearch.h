@@ -0,0 +1,123 @@
+#ifndef JUMPPOINTSEARCH_H
+#define JUMPPOINTSEARCH_H
+
+#include "terrain.h"
+#include "searchworkspace.h"
+#include "MappedFile.h"
+#include <cstdint>
+
+// JPS+ jump distances file, kept next to the map file: JumpDistancesHeader followed by
+// int16_t[verticesNumber * 4] distances (see JumpPointSearch::BuildJumpDistances).
+const char JUMP_DISTANCES_EXTENSION[] = ".jpsplus";
+const char JUMP_DISTANCES_MAGIC[8] = { 'J', 'P', 'S', 'P', 'L', 'U', 'S', '\0' };
+
+// Increase on any change of the layout or of the distances meaning, old files will be rebuilt.
+const uint32_t JUMP_DISTANCES_VERSION = 1;
+
+struct JumpDistancesHeader
+{
+	char Magic[8];
+	uint32_t Version;
+	int32_t Width;
+	int32_t Height;
+	int32_t VerticesNumber;
+	uint64_t TerrainHash; // Terrain::GetHash() of the map the distances were computed for.
+};
+
+/// <summary>
+/// Jump Point Search on a 4-connected grid where all moveable cells cost the same (non-weightened maps).
+/// Instead of expanding every cell, A* expands only jump points: cells where an optimal path may turn.
+/// Every row is kept as 64-bit words of moveable cells, so horizontal jumps skip up to 64 cells
+/// per step with count trailing / leading zeros instead of stepping cell by cell.
+/// Pruning rules (4-connected variant):
+///  - horizontal move stops at a cell with a forced neighbour: the cell above (below) is moveable,
+///    while the one above (below) the previous cell is not;
+///  - vertical move stops at a cell with a forced neighbour or a cell from which a horizontal jump finds a jump point;
+///  - both stop at the finish.
+/// With JPS+ jump distances built (or loaded), jumps are table lookups instead of scans.
+/// </summary>
+class JumpPointSearch
+{
+public:
+	JumpPointSearch();
+
+	/// <summary>
+	/// Packs moveable cells of the terrain into row bitboards. O(cells).
+	/// </summary>
+	void Build(const Terrain& terrain, const FlatArray<int32_t>& vertexCells);
+
+	void Clear();
+
+	/// <summary>
+	/// JPS+ preprocessing: for every vertex and direction computes the distance to the next jump point (positive),
+	/// or, if a block comes first, the number of moveable cells before it (zero or negative). O(cells).
+	/// Jump points here do not depend on the finish; searches check the finish on top of the distances.
+	/// </summary>
+	void BuildJumpDistances();
+
+	/// <summary>
+	/// Writes jump distances into filepath, marked with the terrain hash.
+	/// </summary>
+	bool SaveJumpDistances(const std::string& filepath, uint64_t terrainHash) const;
+
+	/// <summary>
+	/// Maps jump distances saved for the same terrain. Fails if there is no file or it was saved for another terrain.
+	/// </summary>
+	bool LoadJumpDistances(const std::string& filepath, uint64_t terrainHash);
+
+	bool HasJumpDistances() const { return _jumpDistances.GetSize() > 0; }
+
+	bool IsBuilt() const { return _terrain != nullptr; }
+	size_t GetMemoryUsage() const;
+
+	/// <summary>
+	/// Finds shortest path between cells (x1, y1) and (x2, y2). Returns vertex ids of every cell of the path,
+	/// start and finish included, or empty path if finish is not reachable.
+	/// </summary>
+	std::vector<int> FindPath(int x1, int y1, int x2, int y2, SearchWorkspace& workspace) const;
+
+private:
+	bool _IsFree(int row, int column) const
+	{
+		return column >= 0 && column < _width &&
+			((_rows[_RowWord(row, column >> 6)] >> (column & 63)) & 1);
+	}
+
+	/// <summary>
+	/// Index of the word in _rows. Rows -1 and height are padding rows without moveable cells.
+	/// </summary>
+	size_t _RowWord(int row, int word) const { return (size_t)(row + 1) * _wordsPerRow + word; }
+
+	/// <summary>
+	/// Jumps from (row, column) in direction (-1 or +1) along the row. Returns column of the jump point, or -1.
+	/// </summary>
+	int _JumpHorizontally(int row, int column, int direction, int finishRow, int finishColumn) const;
+
+	/// <summary>
+	/// Jumps from (row, column) in direction (-1 or +1) along the column. Returns row of the jump point, or -1.
+	/// </summary>
+	int _JumpVertically(int row, int column, int direction, int finishRow, int finishColumn) const;
+
+	/// <summary>
+	/// Same jump as _JumpHorizontally / _JumpVertically in direction (index of DIRECTION_ROWS), taken from the jump distances.
+	/// Stops at the finish, and for vertical moves at the row of the finish, where horizontal jumps may reach it.
+	/// </summary>
+	bool _LookUpJump(int vertexId, int row, int column, int direction, int finishRow, int finishColumn, int& toRow, int& toColumn) const;
+
+private:
+	const Terrain* _terrain;
+	const FlatArray<int32_t>* _vertexCells;
+
+	int _width;
+	int _height;
+	int _wordsPerRow;
+
+	// Bit (column & 63) of word (column >> 6) of the row is set if the cell is moveable.
+	std::vector<uint64_t> _rows;
+
+	// JPS+ jump distances: 4 per vertex in the order of DIRECTION_ROWS. Own storage or the mapped file.
+	FlatArray<int16_t> _jumpDistances;
+	MappedFile _jumpDistancesFile;
+};
+
+#endif
@@ -0,0 +1,289 @@
+#include "landmarks.h"
+#include "searchqueue.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+LandmarkTable::LandmarkTable() : _landmarksNumber(0), _rowSize(1), _selection(LandmarkSelection::Farthest)
+{
+}
+
+void LandmarkTable::Clear()
+{
+	_landmarks.Clear();
+	_landmarks.ShrinkToFit();
+	_rows.Clear();
+	_rows.ShrinkToFit();
+	_file.Close();
+	_landmarksNumber = 0;
+	_rowSize = 1;
+}
+
+/// <summary>
+/// Picks landmarks one by one: every next one is selected with the distances of the previous ones already in the table.
+/// O(landmarks * (E + V) * log(V)): one or two full Dijkstra searches per landmark.
+/// </summary>
+void LandmarkTable::_Build(const Graph& graph, int landmarksNumber, LandmarkSelection selection)
+{
+	Clear();
+
+	int verticesNumber = graph.GetVerticesNumber();
+	landmarksNumber = std::min(landmarksNumber, verticesNumber);
+	if (landmarksNumber <= 0)
+	{
+		return;
+	}
+
+	_rowSize = landmarksNumber + 1;
+	_rows.Assign((size_t)verticesNumber * _rowSize, INF);
+
+	// All arcs into a vertex cost the same: the cost of its cell.
+	for (int fromId = 0; fromId < verticesNumber; fromId++)
+	{
+		for (const GraphArc& arc : graph[fromId])
+		{
+			_rows.Set((size_t)arc.To * _rowSize, arc.Weight);
+		}
+	}
+
+	_selection = selection;
+
+	auto isLandmark = [&](int vertexId)
+	{
+		return std::find(_landmarks.GetData(), _landmarks.GetData() + _landmarks.GetSize(), vertexId) != _landmarks.GetData() + _landmarks.GetSize();
+	};
+
+	std::mt19937 random(LANDMARKS_SEED);
+	std::uniform_int_distribution<int> vertexIds(0, verticesNumber - 1);
+
+	std::vector<int> distances;
+	std::vector<int> order;
+	std::vector<int> previous;
+
+	// Farthest selection: smallest distance from the landmarks picked so far. The first landmark is the farthest vertex from a random one.
+	std::vector<int> landmarkDistances;
+	if (selection == LandmarkSelection::Farthest)
+	{
+		_RunDijkstra(graph, vertexIds(random), landmarkDistances, order, previous);
+	}
+
+	for (int i = 0; i < landmarksNumber; i++)
+	{
+		int landmarkId = -1;
+
+		if (selection == LandmarkSelection::Farthest)
+		{
+			int maxDistance = -1;
+			for (int vertexId = 0; vertexId < verticesNumber; vertexId++)
+			{
+				if (landmarkDistances[vertexId] < INF && landmarkDistances[vertexId] > maxDistance)
+				{
+					maxDistance = landmarkDistances[vertexId];
+					landmarkId = vertexId;
+				}
+			}
+		}
+		else
+		{
+			landmarkId = _SelectAvoiding(graph, vertexIds(random), distances, order, previous);
+		}
+
+		// Every branch has a landmark already (e.g. tiny map): any other vertex will do.
+		if (landmarkId < 0 || isLandmark(landmarkId))
+		{
+			landmarkId = -1;
+			for (int vertexId = 0; vertexId < verticesNumber && landmarkId < 0; vertexId++)
+			{
+				landmarkId = isLandmark(vertexId) ? -1 : vertexId;
+			}
+		}
+
+		_landmarks.PushBack(landmarkId);
+		_landmarksNumber++;
+
+		_RunDijkstra(graph, landmarkId, distances, order, previous);
+		for (int vertexId = 0; vertexId < verticesNumber; vertexId++)
+		{
+			_rows.Set((size_t)vertexId * _rowSize + _landmarksNumber, distances[vertexId]);
+		}
+
+		if (selection == LandmarkSelection::Farthest)
+		{
+			for (int vertexId = 0; vertexId < verticesNumber; vertexId++)
+			{
+				landmarkDistances[vertexId] = i == 0 ? distances[vertexId] : std::min(landmarkDistances[vertexId], distances[vertexId]);
+			}
+		}
+	}
+}
+
+void LandmarkTable::_RunDijkstra(const Graph& graph, int sourceId, std::vector<int>& distances, std::vector<int>& order, std::vector<int>& previous)
+{
+	int verticesNumber = graph.GetVerticesNumber();
+	distances.assign(verticesNumber, INF);
+	previous.assign(verticesNumber, -1);
+	order.clear();
+
+	RadixHeapQueue q;
+	q.Reset(verticesNumber, INF);
+
+	distances[sourceId] = 0;
+	q.Update(0, sourceId);
+
+	while (!q.IsEmpty())
+	{
+		int distance = q.GetTopKey();
+		int currentId = q.Pop();
+
+		if (distances[currentId] < distance)
+		{
+			continue; // Outdated item, vertex was reached cheaper later.
+		}
+
+		order.push_back(currentId);
+
+		for (const GraphArc& arc : graph[currentId])
+		{
+			int newDistance = distance + arc.Weight;
+			if (distances[arc.To] > newDistance)
+			{
+				distances[arc.To] = newDistance;
+				previous[arc.To] = currentId;
+				q.Update(newDistance, arc.To);
+			}
+		}
+	}
+}
+
+/// <summary>
+/// Every vertex of the tree weighs the error of the lower bound from the root to it. Sizes of the subtrees are summed up
+/// from the leaves in the reverse order of settling, then the walk from the root goes to the heaviest child until a leaf.
+/// </summary>
+int LandmarkTable::_SelectAvoiding(const Graph& graph, int rootId, std::vector<int>& distances, std::vector<int>& order, std::vector<int>& previous) const
+{
+	_RunDijkstra(graph, rootId, distances, order, previous);
+
+	int verticesNumber = graph.GetVerticesNumber();
+	std::vector<long long> sizes(verticesNumber, 0);
+	std::vector<uint8_t> hasLandmark(verticesNumber, 0);
+	std::vector<int> heaviestChildren(verticesNumber, -1);
+
+	for (size_t i = 0; i < _landmarks.GetSize(); i++)
+	{
+		hasLandmark[_landmarks[i]] = 1;
+	}
+
+	for (auto it = order.rbegin(); it != order.rend(); ++it)
+	{
+		int vertexId = *it;
+		sizes[vertexId] = hasLandmark[vertexId] ? 0 : sizes[vertexId] + distances[vertexId] - Estimate(rootId, vertexId);
+
+		int parentId = previous[vertexId];
+		if (parentId < 0)
+		{
+			continue;
+		}
+
+		hasLandmark[parentId] |= hasLandmark[vertexId];
+		sizes[parentId] += sizes[vertexId];
+
+		if (sizes[vertexId] > 0 && (heaviestChildren[parentId] < 0 || sizes[vertexId] > sizes[heaviestChildren[parentId]]))
+		{
+			heaviestChildren[parentId] = vertexId;
+		}
+	}
+
+	if (heaviestChildren[rootId] < 0)
+	{
+		return -1;
+	}
+
+	int vertexId = rootId;
+	while (heaviestChildren[vertexId] >= 0)
+	{
+		vertexId = heaviestChildren[vertexId];
+	}
+
+	return vertexId;
+}
+
+/// <summary>
+/// Writes the tables into filepath, marked with the terrain hash.
+/// </summary>
+bool LandmarkTable::Save(const std::string& filepath, uint64_t terrainHash) const
+{
+	if (!IsBuilt())
+	{
+		return false;
+	}
+
+	LandmarksHeader header = {};
+	memcpy(header.Magic, LANDMARKS_MAGIC, sizeof(header.Magic));
+	header.Version = LANDMARKS_VERSION;
+	header.VerticesNumber = (int32_t)(_rows.GetSize() / _rowSize);
+	header.LandmarksNumber = _landmarksNumber;
+	header.Selection = (int32_t)_selection;
+	header.TerrainHash = terrainHash;
+
+	std::ofstream output(filepath, std::ios::binary | std::ios::trunc);
+	if (!output)
+	{
+		std::cerr << "Error opening " << filepath << " for writing." << std::endl;
+		return false;
+	}
+
+	output.write((const char*)&header, sizeof(header));
+	output.write((const char*)_landmarks.GetData(), _landmarks.GetSize() * sizeof(int32_t));
+	output.write((const char*)_rows.GetData(), _rows.GetSize() * sizeof(int32_t));
+
+	if (!output)
+	{
+		std::cerr << "Error writing " << filepath << "." << std::endl;
+		return false;
+	}
+
+	std::cout << "Landmarks saved to " << filepath << " (" << GetMemoryUsage() / 1024 << " KB)." << std::endl;
+
+	return true;
+}
+
+/// <summary>
+/// Maps the tables saved for the same terrain, number of vertices and landmarks and selection.
+/// </summary>
+bool LandmarkTable::Load(const std::string& filepath, uint64_t terrainHash, int verticesNumber, int landmarksNumber, LandmarkSelection selection)
+{
+	Clear();
+
+	if (!_file.Open(filepath))
+	{
+		return false;
+	}
+
+	const LandmarksHeader* header = (const LandmarksHeader*)_file.GetData();
+
+	if (_file.GetSize() < sizeof(LandmarksHeader) ||
+		memcmp(header->Magic, LANDMARKS_MAGIC, sizeof(header->Magic)) != 0 ||
+		header->Version != LANDMARKS_VERSION ||
+		header->VerticesNumber != verticesNumber ||
+		header->Selection != (int32_t)selection ||
+		header->TerrainHash != terrainHash ||
+		// Tiny maps get fewer landmarks than asked for.
+		header->LandmarksNumber != std::min(landmarksNumber, verticesNumber) ||
+		_file.GetSize() != sizeof(LandmarksHeader) + ((size_t)header->LandmarksNumber + (size_t)verticesNumber * (header->LandmarksNumber + 1)) * sizeof(int32_t))
+	{
+		std::cout << filepath << " was saved for another version of the map or landmarks, landmarks will be computed again." << std::endl;
+		_file.Close();
+		return false;
+	}
+
+	_landmarksNumber = header->LandmarksNumber;
+	_rowSize = _landmarksNumber + 1;
+	_selection = selection;
+
+	const int32_t* data = (const int32_t*)(_file.GetData() + sizeof(LandmarksHeader));
+	_landmarks.Attach(data, _landmarksNumber);
+	_rows.Attach(data + _landmarksNumber, (size_t)verticesNumber * _rowSize);
+
+	return true;
+}
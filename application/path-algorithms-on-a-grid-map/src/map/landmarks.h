@@ -0,0 +1,151 @@
+#ifndef LANDMARKS_H
+#define LANDMARKS_H
+
+#include "graph.h"
+#include "MappedFile.h"
+#include "common.h"
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+// ALT landmark distances file, kept next to the map file: LandmarksHeader followed by int32_t[landmarksNumber]
+// landmark vertex ids and int32_t[verticesNumber * (landmarksNumber + 1)] rows (see LandmarkTable).
+const char LANDMARKS_EXTENSION[] = ".landmarks";
+const char LANDMARKS_MAGIC[8] = { 'L', 'A', 'N', 'D', 'M', 'R', 'K', '\0' };
+
+// Increase on any change of the layout, of the distances meaning or of the selection, old files will be rebuilt.
+const uint32_t LANDMARKS_VERSION = 1;
+
+// Seed of the random roots of the landmark selection: the same map always gets the same landmarks.
+const unsigned int LANDMARKS_SEED = 20240601;
+
+/// <summary>
+/// How landmarks are picked. Farthest: every next landmark is the vertex farthest from the landmarks picked so far.
+/// Avoid: shortest path tree is grown from a random root, and the next landmark is the leaf of its subtree
+/// where the current landmarks give the worst lower bounds (Goldberg and Werneck).
+/// </summary>
+enum class LandmarkSelection
+{
+	Farthest,
+	Avoid
+};
+
+struct LandmarksHeader
+{
+	char Magic[8];
+	uint32_t Version;
+	int32_t VerticesNumber;
+	int32_t LandmarksNumber;
+	int32_t Selection;
+	uint64_t TerrainHash; // Terrain::GetHash() of the map the distances were computed for.
+};
+
+/// <summary>
+/// Distances from a few landmark vertices to every vertex, for A* lower bounds by the triangle inequality (ALT):
+///   d(v, t) >= d(L, t) - d(L, v) and d(v, t) >= d(v, L) - d(t, L).
+/// Arc into a cell costs the cost of the cell, so the path back costs d(v, L) = d(L, v) - cost(v) + cost(L):
+/// one Dijkstra per landmark gives both bounds. Every vertex has a row of the table with its cost and its distances
+/// from all landmarks, so an estimate reads two rows only. Vertices not reachable from a landmark have INF there,
+/// which still gives lower bounds: such vertices cannot reach the other ones at all.
+/// </summary>
+class LandmarkTable
+{
+public:
+	LandmarkTable();
+
+	/// <summary>
+	/// Picks landmarksNumber landmarks and computes distances from them over the graph (Graph or GridGraph).
+	/// </summary>
+	template <typename TGraph>
+	void Build(const TGraph& graph, int landmarksNumber, LandmarkSelection selection)
+	{
+		if constexpr (std::is_same_v<TGraph, Graph>)
+		{
+			_Build(graph, landmarksNumber, selection);
+		}
+		else
+		{
+			// Dijkstra runs over CSR arrays: the implicit grid graph is packed into them first.
+			Graph packed;
+			packed.Reset(graph.GetVerticesNumber());
+			for (int fromId = 0; fromId < graph.GetVerticesNumber(); fromId++)
+			{
+				graph.ForEachArc(fromId, [&](int toId, int weight) { packed.AddArc(fromId, toId, weight); });
+			}
+			packed.Finish();
+
+			_Build(packed, landmarksNumber, selection);
+		}
+	}
+
+	void Clear();
+
+	bool IsBuilt() const { return _landmarksNumber > 0; }
+	int GetLandmarksNumber() const { return _landmarksNumber; }
+	const FlatArray<int32_t>& GetLandmarks() const { return _landmarks; }
+
+	/// <summary>
+	/// Size of the tables, whether they are owned or mapped from the file.
+	/// </summary>
+	size_t GetMemoryUsage() const { return (_landmarks.GetSize() + _rows.GetSize()) * sizeof(int32_t); }
+
+	/// <summary>
+	/// Writes the tables into filepath, marked with the terrain hash.
+	/// </summary>
+	bool Save(const std::string& filepath, uint64_t terrainHash) const;
+
+	/// <summary>
+	/// Maps the tables saved for the same terrain, number of vertices and landmarks and selection.
+	/// Fails if there is no file or it was saved for something else.
+	/// </summary>
+	bool Load(const std::string& filepath, uint64_t terrainHash, int verticesNumber, int landmarksNumber, LandmarkSelection selection);
+
+	/// <summary>
+	/// Lower bound of the distance from fromId to toId.
+	/// </summary>
+	int Estimate(int fromId, int toId) const
+	{
+		const int32_t* from = _rows.GetData() + (size_t)fromId * _rowSize;
+		const int32_t* to = _rows.GetData() + (size_t)toId * _rowSize;
+
+		// The first element of the row is the cost of the vertex, the rest are distances from the landmarks.
+		int fromCost = from[0];
+		int toCost = to[0];
+		int estimate = 0;
+
+		for (int i = 1; i < _rowSize; i++)
+		{
+			estimate = std::max(estimate, to[i] - from[i]);
+			estimate = std::max(estimate, (from[i] - fromCost) - (to[i] - toCost));
+		}
+
+		return estimate;
+	}
+
+private:
+	void _Build(const Graph& graph, int landmarksNumber, LandmarkSelection selection);
+
+	/// <summary>
+	/// Dijkstra from the source over the whole graph: distances (INF for unreachable vertices),
+	/// vertices in the order they were settled and their previous vertices in the shortest path tree.
+	/// </summary>
+	static void _RunDijkstra(const Graph& graph, int sourceId, std::vector<int>& distances, std::vector<int>& order, std::vector<int>& previous);
+
+	/// <summary>
+	/// Leaf of the shortest path tree of the root with the largest sum of the bound errors d(root, v) - Estimate(root, v)
+	/// in its branch, branches with a landmark skipped. Returns -1 if every branch has a landmark already.
+	/// </summary>
+	int _SelectAvoiding(const Graph& graph, int rootId, std::vector<int>& distances, std::vector<int>& order, std::vector<int>& previous) const;
+
+private:
+	int _landmarksNumber;
+	int _rowSize; // Cost of the vertex and its distances from the landmarks.
+	LandmarkSelection _selection;
+
+	FlatArray<int32_t> _landmarks;
+	FlatArray<int32_t> _rows;
+	MappedFile _file;
+};
+
+#endif
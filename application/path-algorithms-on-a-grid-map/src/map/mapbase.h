@@ -2,8 +2,76 @@
 #define MAPBASE_H
 
 #include "graph.h"
+#include "gridgraph.h"
+#include "jumppointsearch.h"
+#include "hierarchicalsearch.h"
+#include "contractionhierarchy.h"
+#include "landmarks.h"
+#include "pathdatabase.h"
+#include "connectedcomponents.h"
+#include "edgelist.h"
+#include "terrain.h"
+#include "coordinate.h"
 #include "focus.h"
+#include "MappedFile.h"
 #include "VisiblePartObserver.h"
+#include <unordered_map>
+#include <string_view>
+
+/// <summary>
+/// Priority queue of the weighten searches (see searchqueue.h). Auto picks Dial's buckets for small weights.
+/// </summary>
+enum class SearchQueueType
+{
+	Auto,
+	BinaryHeap,
+	IndexedHeap,
+	RadixHeap,
+	Buckets
+};
+
+/// <summary>
+/// Distance estimate of A* searches (see searchheuristic.h). Manhattan by default, Zero turns A* into Dijkstra.
+/// Landmarks needs the landmark table (see MapBase::UseLandmarks), otherwise Manhattan is used.
+/// </summary>
+enum class SearchHeuristicType
+{
+	Manhattan,
+	Octile,
+	Euclidean,
+	Zero,
+	Landmarks
+};
+
+/// <summary>
+/// Order of the open list items with equal keys in A* searches. At equal f = g + h, higher g means lower h.
+/// None leaves it to the queue: vertex id for heaps, last in first out for buckets and radix heap.
+/// </summary>
+enum class SearchTieBreaking
+{
+	None,
+	HigherG,
+	Lifo
+};
+
+/// <summary>
+/// Path finding algorithm of maps without negative cells. Auto picks contraction hierarchy or hierarchical search if it is built
+/// (see MapBase::UseContractionHierarchy and MapBase::UseHierarchicalSearch), otherwise jump point search for non-weightened maps
+/// and bidirectional A* for weightened ones. Bidirectional BFS, like jump point search, works only for non-weightened maps.
+/// Auto and PathDatabase read paths from the path database if it has the row of the start (see MapBase::UsePathDatabase),
+/// the rest of the queries go to the algorithm Auto picks.
+/// </summary>
+enum class SearchAlgorithm
+{
+	Auto,
+	AStar,
+	BidirectionalAStar,
+	JumpPointSearch,
+	BidirectionalBFS,
+	Hierarchical,
+	ContractionHierarchy,
+	PathDatabase
+};
 
 class MapBase : public VisiblePartObserver
 {
@@ -25,37 +93,261 @@ public:
 
 	virtual bool IsReady() = 0;
 
+	/// <summary>
+	/// Writes loaded map with its graph into the compiled binary format (see compiledmap.h),
+	/// so next time it opens without parsing and building the graph.
+	/// </summary>
+	bool SaveCompiledMap(const std::string& filepath) const;
+
+	/// <summary>
+	/// Orders section (T, D and orders of every iteration) of the loaded map file.
+	/// Map file is read only once: the view refers to its mapping, which lives as long as the map.
+	/// </summary>
+	std::string_view GetOrders() const;
+
+	/// <summary>
+	/// Switches path finding to the implicit grid graph: neighbours are derived from the terrain on the fly,
+	/// so there is no adjacency list to build. Ignored for maps with negative cells. Call before LoadMap.
+	/// </summary>
+	void UseImplicitGraph(bool enabled);
+
+	/// <summary>
+	/// Selects priority queue of Dijkstra and A* searches. Auto by default.
+	/// Buckets are used only for maps with small integer weights, otherwise Auto and Buckets fall back to the radix heap.
+	/// </summary>
+	void UseSearchQueue(SearchQueueType type);
+
+	/// <summary>
+	/// Selects distance estimate of A* searches. Manhattan by default: it is exact on the 4-connected grid without blocks.
+	/// </summary>
+	void UseSearchHeuristic(SearchHeuristicType type);
+
+	/// <summary>
+	/// Selects order of the open list items with equal keys in A* searches. None by default.
+	/// </summary>
+	void UseTieBreaking(SearchTieBreaking tieBreaking);
+
+	/// <summary>
+	/// With closed set (default) A* searches never take an expanded vertex again: outdated items of the open list are skipped
+	/// as soon as they are popped. Without it, searches compare keys of popped items and may re-expand a vertex reached cheaper,
+	/// which only happens with inconsistent heuristics.
+	/// </summary>
+	void UseClosedSet(bool enabled);
+
+	/// <summary>
+	/// On maps with negative cells, finds paths by Bellman-Ford passes over the whole edge list instead of
+	/// the queue-based Bellman-Ford over the adjacency list (default). Passes take O(E) each and stop as soon as
+	/// one relaxes nothing, so this is for comparison: the queue scans only vertices whose distance has changed.
+	/// </summary>
+	void UseEdgeListBellmanFord(bool enabled);
+
+	/// <summary>
+	/// Selects path finding algorithm. Jump point search and bidirectional BFS work only for non-weightened maps,
+	/// hierarchical search and contraction hierarchy only when they are built, otherwise they fall back to Auto.
+	/// </summary>
+	void UseSearchAlgorithm(SearchAlgorithm algorithm);
+
+	/// <summary>
+	/// Builds hierarchical path finding (HPA*) over clusters of clusterSize x clusterSize cells, so paths are found
+	/// on the small abstract graph instead of the whole grid. Paths may be slightly longer than the shortest ones.
+	/// 0 turns it off. Called before LoadMap, it is built with the graph; called later, it is built right away.
+	/// </summary>
+	void UseHierarchicalSearch(int clusterSize);
+
+	/// <summary>
+	/// Builds contraction hierarchy of the graph, so exact paths are found by searches settling a few hundreds of vertices.
+	/// Preprocessing takes seconds on large maps, so it pays off for static maps with many queries.
+	/// Called before LoadMap, it is built with the graph; called later, it is built right away.
+	/// </summary>
+	void UseContractionHierarchy(bool enabled);
+
+	/// <summary>
+	/// Computes distances from landmarksNumber landmarks for the Landmarks heuristic (ALT), which bounds the distance
+	/// by the real costs around blocks and grass instead of the straight line. Tables are saved next to the map file
+	/// and loaded from it next time. 0 turns them off. Called before LoadMap, they are built with the graph;
+	/// called later, they are built right away.
+	/// </summary>
+	void UseLandmarks(int landmarksNumber, LandmarkSelection selection = LandmarkSelection::Farthest);
+
+	/// <summary>
+	/// Computes compressed path database (shortest path trees of the sources), so paths from the sources are read
+	/// from the table with no search. Every moveable cell is a source if sources are empty: the table takes minutes
+	/// and hundreds of megabytes on large maps, so it may be restricted to the cells paths start from most often
+	/// (see GetFrequentOrderCells). Table is saved next to the map file and loaded from it next time.
+	/// Called before LoadMap, it is built with the graph; called later, it is built right away.
+	/// </summary>
+	void UsePathDatabase(bool enabled, const std::vector<Coordinate>& sources = {});
+
+	/// <summary>
+	/// Pickup and dropoff cells of the orders section, the most frequent first, cellsNumber at most.
+	/// Rover paths start from them: from the dropoff of the previous order and from the pickup of the current one.
+	/// </summary>
+	std::vector<Coordinate> GetFrequentOrderCells(int cellsNumber) const;
+
 	virtual void Draw() const;
 
 	void PrintMapSVG(const std::string& filename) const;
 
-	std::shared_ptr<Cell> GetCellFromGrid(int row, int column) const;
+	/// <summary>
+	/// Highlights the cell on the map (e.g. to show the path). Does not change the terrain.
+	/// </summary>
+	void SetCellColor(int x, int y, const sf::Color& color);
+
+	/// <summary>
+	/// Gets graph vertex id of the cell, or -1 if cell is not moveable.
+	/// </summary>
+	int GetVertexId(int x, int y) const;
+	Coordinate GetVertexCoordinate(int vertexId) const;
+	int GetVerticesNumber() const { return _verticesNumber; }
+
+	/// <summary>
+	/// Some cells of the loaded map are negative (e.g. water), so paths are found by Bellman-Ford.
+	/// </summary>
+	bool HasNegativeCells() const { return _isNegativeWeighten; }
+
+	/// <summary>
+	/// Both cells are moveable and connected, and the start is not a negative cell. Takes constant time: components are labelled
+	/// when the graph is built. Negative cells have a single arc into them and no arcs out of them, so components join them
+	/// to their neighbours and a start in one is rejected here: it reaches no other cell.
+	/// </summary>
+	bool IsReachable(int x1, int y1, int x2, int y2) const;
+
+	/// <summary>
+	/// Sum of the step costs along the path: cost of every cell except the first one.
+	/// </summary>
+	int GetPathCost(const std::vector<Coordinate>& path) const;
 
 public:
 	virtual std::tuple<float, float, float, float> GetCoordinateBounds() const = 0;
-	virtual std::shared_ptr<Cell> GetFirstMoveableCell() const;
+	virtual Coordinate GetFirstMoveableCell() const;
 
-	virtual std::vector<std::shared_ptr<Cell>> GetPath(int x1, int y1, int x2, int y2) const = 0;
+	virtual std::vector<Coordinate> GetPath(int x1, int y1, int x2, int y2) const = 0;
 
 public:
 	void UpdateVisiblePart(float topLeftX, float topLeftY, float bottomRightX, float bottomRightY);
 
+protected:
+	bool _IsImplicitGraphUsed() const;
+	SearchQueueType _GetSearchQueueType() const;
+	SearchAlgorithm _GetSearchAlgorithm() const;
+
+	/// <summary>
+	/// Builds hierarchical search for the loaded map if cluster size is set and the map has no negative cells.
+	/// </summary>
+	void _InitialiseHierarchicalSearch();
+
+	/// <summary>
+	/// Labels connected components of the graph used for searches and logs their sizes.
+	/// </summary>
+	void _InitialiseComponents();
+
+	/// <summary>
+	/// Builds contraction hierarchy of the graph used for searches if it is enabled and the map has no negative cells.
+	/// </summary>
+	void _InitialiseContractionHierarchy();
+
+	/// <summary>
+	/// Loads landmark tables saved for the map or computes and saves them, if landmarks are enabled and the map has no negative cells.
+	/// </summary>
+	void _InitialiseLandmarks();
+
+	/// <summary>
+	/// Loads path database saved for the map and the sources or computes and saves it, if it is enabled and the map has no negative cells.
+	/// </summary>
+	void _InitialisePathDatabase();
+
+	/// <summary>
+	/// Adjacency list (or the implicit grid graph) is built for the loaded map.
+	/// </summary>
+	bool _IsGraphBuilt() const;
+
+	/// <summary>
+	/// Secondary key of the open list item: distance (g) of the vertex and number of items generated before it.
+	/// </summary>
+	int _GetTieKey(int distance, int order) const
+	{
+		switch (_tieBreaking)
+		{
+		case SearchTieBreaking::None:
+			return 0;
+		case SearchTieBreaking::HigherG:
+			return -distance;
+		case SearchTieBreaking::Lifo:
+			return -order;
+		}
+
+		return 0;
+	}
+
+	/// <summary>
+	/// Highest cost of a step into a moveable cell.
+	/// </summary>
+	int _GetMaxWeight() const;
+
+	/// <summary>
+	/// Lowest cost of a step into a moveable cell, 0 if some cells are negative.
+	/// </summary>
+	int _GetMinWeight() const;
+
+	/// <summary>
+	/// Maps compiled map file into memory and points terrain, vertex cells and graph right to its sections.
+	/// </summary>
+	bool _LoadCompiledMap(const std::string& filepath);
+
+	sf::Color _GetCellColor(int index) const;
+	void _DrawTile(int x, int y, sf::Color color) const;
+
+	/// <summary>
+	/// Converts list of vertex ids into the list of map coordinates.
+	/// </summary>
+	std::vector<Coordinate> _ToCoordinates(const std::vector<int>& vertexIds) const;
+
 protected:
 	int _width;
 	int _height;
 	int _verticesNumber;
 
-	// List of cells to easily get Cell Description (coordinates, symbol, color, etc.) by Index
-	vector<std::shared_ptr<Cell>> _moveableCells;
+	// Grid representation of our map: symbol, vertex id and cost of every cell in flat arrays.
+	Terrain _terrain;
+
+	// Vertex id -> terrain index (row * width + column) of the moveable cell.
+	FlatArray<int32_t> _vertexCells;
+
+	// The rest of the map file header.
+	int _maxTips;
+	int _roverCost;
 
-	// Grid representation of our map.
-	vector<vector<std::shared_ptr<Cell>>> _grid;
+	// Loaded map file (text or compiled) is kept mapped: orders, and for compiled maps terrain and graph, refer to it.
+	// Preprocessed data (e.g. landmark tables) is saved next to it.
+	std::string _mapFilepath;
+	MappedFile _mapFile;
+	std::string_view _orders;
+
+	// Cells highlighted on top of the terrain colors (e.g. found paths).
+	std::unordered_map<int, sf::Color> _highlightedCells;
 
 	// Graph representations of our map that:
 	// 1. Avoids non-moveable cells to build the paths more efficiently (than in Grid).
 	// 2. Allows applying appropriate graph algorithms based on map data.
+	// Adjacency list is kept in CSR form with the edge weights inlined.
 	Graph _adjacencyList;
-	GraphEdgesList _edgesList;
+	Graph _reverseAdjacencyList; // Built for weighten maps only, where backward searches need it.
+	GridGraph _gridGraph;
+	JumpPointSearch _jumpPointSearch; // Built for non-weightened maps only.
+	ConnectedComponents _components; // Labelled with the graph, see IsReachable.
+	HierarchicalSearch _hierarchicalSearch; // Built on demand, see UseHierarchicalSearch.
+	int _hierarchicalClusterSize;
+	ContractionHierarchy _contractionHierarchy; // Built on demand, see UseContractionHierarchy.
+	bool _useContractionHierarchy;
+	LandmarkTable _landmarkTable; // Built on demand, see UseLandmarks.
+	int _landmarksNumber;
+	LandmarkSelection _landmarkSelection;
+	PathDatabase _pathDatabase; // Built on demand, see UsePathDatabase.
+	bool _usePathDatabase;
+	std::vector<Coordinate> _pathDatabaseSources;
+	bool _useImplicitGraph;
+	EdgeList _edgesList; // Arcs of maps with negative cells as parallel arrays, for Bellman-Ford over the edge list.
+	bool _useEdgeList;
 
 	/// <summary>
 	/// Is set if map cells loaded from the file contain more than 2 potential states (like: block, grass and water).
@@ -67,9 +359,25 @@ protected:
 	/// </summary>
 	bool _isNegativeWeighten;
 
+	/// <summary>
+	/// Highest cost of a step into a moveable cell. Limits the growth of the search keys per step.
+	/// </summary>
+	int _maxWeight;
+
+	/// <summary>
+	/// Lowest cost of a step into a moveable cell. Scales heuristic estimates measured in steps, so they stay admissible.
+	/// </summary>
+	int _minWeight;
+	SearchQueueType _searchQueueType;
+	SearchHeuristicType _searchHeuristicType;
+	SearchTieBreaking _tieBreaking;
+	bool _useClosedSet;
+	SearchAlgorithm _searchAlgorithm;
+
 	// Visualization staff.
 	RenderWindow& _window;
 	float _scaleFactor;
+	bool _shadow;
 
 	float _visibleTopLeftX;
 	float _visibleTopLeftY;
@@ -1,16 +1,58 @@
 #include "mapbase.h"
+#include "compiledmap.h"
+#include "orderreader.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <map>
+
+namespace
+{
+	/// <summary>
+	/// Section of count elements of elementSize bytes at offset lies within the file and is aligned for its elements.
+	/// </summary>
+	bool IsSectionInFile(uint64_t offset, uint64_t count, size_t elementSize, size_t fileSize)
+	{
+		return offset <= fileSize && offset % elementSize == 0 && count <= (fileSize - offset) / elementSize;
+	}
+
+	/// <summary>
+	/// Each of count values lies within [min, end).
+	/// </summary>
+	bool AreValuesInRange(const int32_t* values, uint64_t count, int64_t min, int64_t end)
+	{
+		return std::all_of(values, values + count, [=](int32_t value) { return value >= min && value < end; });
+	}
+}
 
 MapBase::MapBase(RenderWindow& window, int width, int height) :
-	_window(window),
 	_width(width),
 	_height(height),
+	_maxTips(0),
+	_roverCost(0),
+	_hierarchicalClusterSize(0),
+	_useContractionHierarchy(false),
+	_landmarksNumber(0),
+	_landmarkSelection(LandmarkSelection::Farthest),
+	_usePathDatabase(false),
+	_useImplicitGraph(false),
+	_useEdgeList(false),
+	_isWeighten(false),
+	_isNegativeWeighten(false),
+	_maxWeight(1),
+	_minWeight(1),
+	_searchQueueType(SearchQueueType::Auto),
+	_searchHeuristicType(SearchHeuristicType::Manhattan),
+	_tieBreaking(SearchTieBreaking::None),
+	_useClosedSet(true),
+	_searchAlgorithm(SearchAlgorithm::Auto),
+	_window(window),
 	_scaleFactor(1),
+	_shadow(false),
 	_visibleTopLeftX(0),
 	_visibleTopLeftY(0),
-	_visibleBottomRightX(_grid.size()),
-	_visibleBottomRightY(_grid.size()),
-	_isNegativeWeighten(false),
-	_isWeighten(false)
+	_visibleBottomRightX(0),
+	_visibleBottomRightY(0)
 {
 	_verticesNumber = width * height;
 }
@@ -26,10 +68,605 @@ MapBase::~MapBase()
 /// </summary>
 void MapBase::InitialiseGraph()
 {
-	_adjacencyList.clear();
-	_adjacencyList.resize(_verticesNumber);
+	_adjacencyList.Reset(_verticesNumber, _IsImplicitGraphUsed() ? 0 : (size_t)_verticesNumber * 4);
+	_reverseAdjacencyList.Reset(0);
+	_gridGraph.Clear();
+
+	_edgesList.Clear();
+}
+
+std::string_view MapBase::GetOrders() const
+{
+	return _orders;
+}
+
+/// <summary>
+/// Writes loaded map with its graph into the compiled binary format (see compiledmap.h),
+/// so next time it opens without parsing and building the graph.
+/// </summary>
+bool MapBase::SaveCompiledMap(const std::string& filepath) const
+{
+	// Take arcs from the graph representation in use, so maps loaded with the implicit grid graph are compiled as well.
+	std::vector<int32_t> offsets(_verticesNumber + 1, 0);
+	std::vector<GraphArc> arcs;
+	auto collectArcs = [&](const auto& graph)
+	{
+		for (int vertexId = 0; vertexId < _verticesNumber; vertexId++)
+		{
+			graph.ForEachArc(vertexId, [&](int toId, int weight)
+			{
+				arcs.push_back({ toId, weight });
+			});
+
+			offsets[vertexId + 1] = (int32_t)arcs.size();
+		}
+	};
+
+	if (_IsImplicitGraphUsed())
+	{
+		collectArcs(_gridGraph);
+	}
+	else
+	{
+		collectArcs(_adjacencyList);
+	}
+
+	size_t cellsNumber = (size_t)_terrain.GetSize();
+	auto align = [](uint64_t offset) { return (offset + 7) & ~(uint64_t)7; };
+
+	CompiledMapHeader header = {};
+	memcpy(header.Magic, COMPILED_MAP_MAGIC, sizeof(header.Magic));
+	header.Version = COMPILED_MAP_VERSION;
+	header.MapSize = _terrain.GetHeight();
+	header.MaxTips = _maxTips;
+	header.RoverCost = _roverCost;
+	header.Width = _terrain.GetWidth();
+	header.Height = _terrain.GetHeight();
+	header.VerticesNumber = _verticesNumber;
+	header.IsWeighten = _isWeighten;
+	header.IsNegativeWeighten = _isNegativeWeighten;
+	header.ArcsNumber = arcs.size();
+	header.SymbolsOffset = align(sizeof(CompiledMapHeader));
+	header.VertexIdsOffset = align(header.SymbolsOffset + cellsNumber * sizeof(char));
+	header.CostsOffset = align(header.VertexIdsOffset + cellsNumber * sizeof(int32_t));
+	header.VertexCellsOffset = align(header.CostsOffset + cellsNumber * sizeof(int8_t));
+	header.GraphOffsetsOffset = align(header.VertexCellsOffset + _vertexCells.GetSize() * sizeof(int32_t));
+	header.GraphArcsOffset = align(header.GraphOffsetsOffset + offsets.size() * sizeof(int32_t));
+	header.OrdersOffset = align(header.GraphArcsOffset + arcs.size() * sizeof(GraphArc));
+	header.OrdersSize = _orders.size();
+
+	std::ofstream output(filepath, std::ios::binary | std::ios::trunc);
+	if (!output)
+	{
+		std::cerr << "Error opening " << filepath << " for writing." << std::endl;
+		return false;
+	}
+
+	uint64_t position = 0;
+	auto writeSection = [&](uint64_t offset, const void* data, size_t size)
+	{
+		static const char padding[8] = {};
+		output.write(padding, offset - position);
+		output.write((const char*)data, size);
+		position = offset + size;
+	};
+
+	writeSection(0, &header, sizeof(header));
+	writeSection(header.SymbolsOffset, _terrain.GetSymbols(), cellsNumber * sizeof(char));
+	writeSection(header.VertexIdsOffset, _terrain.GetVertexIds(), cellsNumber * sizeof(int32_t));
+	writeSection(header.CostsOffset, _terrain.GetCosts(), cellsNumber * sizeof(int8_t));
+	writeSection(header.VertexCellsOffset, _vertexCells.GetData(), _vertexCells.GetSize() * sizeof(int32_t));
+	writeSection(header.GraphOffsetsOffset, offsets.data(), offsets.size() * sizeof(int32_t));
+	writeSection(header.GraphArcsOffset, arcs.data(), arcs.size() * sizeof(GraphArc));
+	writeSection(header.OrdersOffset, _orders.data(), _orders.size());
+
+	if (!output)
+	{
+		std::cerr << "Error writing " << filepath << "." << std::endl;
+		return false;
+	}
+
+	std::cout << "Compiled map saved to " << filepath << " (" << position / 1024 << " KB)." << std::endl;
+
+	return true;
+}
+
+/// <summary>
+/// Maps compiled map file into memory and points terrain, vertex cells and graph right to its sections.
+/// </summary>
+bool MapBase::_LoadCompiledMap(const std::string& filepath)
+{
+	if (!_mapFile.Open(filepath))
+	{
+		return false;
+	}
+
+	const char* data = _mapFile.GetData();
+	const CompiledMapHeader* header = (const CompiledMapHeader*)data;
+
+	if (_mapFile.GetSize() < sizeof(CompiledMapHeader) ||
+		memcmp(header->Magic, COMPILED_MAP_MAGIC, sizeof(header->Magic)) != 0 ||
+		header->Version != COMPILED_MAP_VERSION)
+	{
+		std::cerr << filepath << " is not a compiled map of version " << COMPILED_MAP_VERSION << ". Compile it again from the text map." << std::endl;
+		_mapFile.Close();
+		return false;
+	}
+
+	// Sections are used right from the mapping, so a truncated or damaged file must not point past its end.
+	size_t fileSize = _mapFile.GetSize();
+	uint64_t cellsNumber = (uint64_t)std::max(header->Width, 0) * (uint64_t)std::max(header->Height, 0);
+	uint64_t verticesNumber = (uint64_t)std::max(header->VerticesNumber, 0);
+
+	bool valid = header->Width > 0 && header->Height > 0 &&
+		header->VerticesNumber >= 0 && verticesNumber <= cellsNumber &&
+		IsSectionInFile(header->SymbolsOffset, cellsNumber, sizeof(char), fileSize) &&
+		IsSectionInFile(header->VertexIdsOffset, cellsNumber, sizeof(int32_t), fileSize) &&
+		IsSectionInFile(header->CostsOffset, cellsNumber, sizeof(int8_t), fileSize) &&
+		IsSectionInFile(header->VertexCellsOffset, verticesNumber, sizeof(int32_t), fileSize) &&
+		IsSectionInFile(header->GraphOffsetsOffset, verticesNumber + 1, sizeof(int32_t), fileSize) &&
+		IsSectionInFile(header->GraphArcsOffset, header->ArcsNumber, sizeof(GraphArc), fileSize) &&
+		IsSectionInFile(header->OrdersOffset, header->OrdersSize, sizeof(char), fileSize);
+
+	// Arcs of every vertex are found through the offsets, so they have to cover the arcs section exactly and never go back.
+	// Searches index cells and vertices by the ids stored in the sections without checks, so every id has to be in range.
+	if (valid)
+	{
+		const int32_t* graphOffsets = (const int32_t*)(data + header->GraphOffsetsOffset);
+		valid = graphOffsets[0] == 0 && (uint64_t)graphOffsets[verticesNumber] == header->ArcsNumber &&
+			std::is_sorted(graphOffsets, graphOffsets + verticesNumber + 1);
+	}
+
+	if (valid)
+	{
+		const GraphArc* arcs = (const GraphArc*)(data + header->GraphArcsOffset);
+		valid = std::all_of(arcs, arcs + header->ArcsNumber, [=](const GraphArc& arc) { return arc.To >= 0 && (uint64_t)arc.To < verticesNumber; }) &&
+			AreValuesInRange((const int32_t*)(data + header->VertexIdsOffset), cellsNumber, -1, (int64_t)verticesNumber) &&
+			AreValuesInRange((const int32_t*)(data + header->VertexCellsOffset), verticesNumber, 0, (int64_t)cellsNumber);
+	}
+
+	if (!valid)
+	{
+		std::cerr << filepath << " is damaged: its sections do not fit the file. Compile it again from the text map." << std::endl;
+		_mapFile.Close();
+		return false;
+	}
+
+	_terrain.Attach(header->Width, header->Height,
+		data + header->SymbolsOffset,
+		(const int32_t*)(data + header->VertexIdsOffset),
+		(const int8_t*)(data + header->CostsOffset));
+	_vertexCells.Attach((const int32_t*)(data + header->VertexCellsOffset), header->VerticesNumber);
+	_adjacencyList.Attach(header->VerticesNumber,
+		(const int32_t*)(data + header->GraphOffsetsOffset),
+		(const GraphArc*)(data + header->GraphArcsOffset),
+		header->ArcsNumber);
+	_gridGraph.Clear();
+
+	_verticesNumber = header->VerticesNumber;
+	_isWeighten = header->IsWeighten;
+	_isNegativeWeighten = header->IsNegativeWeighten;
+	_maxWeight = _GetMaxWeight();
+	_minWeight = _GetMinWeight();
+	_maxTips = header->MaxTips;
+	_roverCost = header->RoverCost;
+
+	// Orders are kept as text at the end of the file, so Navigator reads them as from the text map.
+	_orders = std::string_view(data + header->OrdersOffset, header->OrdersSize);
+
+	return true;
+}
+
+void MapBase::UseImplicitGraph(bool enabled)
+{
+	_useImplicitGraph = enabled;
+}
+
+bool MapBase::_IsImplicitGraphUsed() const
+{
+	// Negative cells are single-directed, which the implicit grid cannot express.
+	return _useImplicitGraph && !_isNegativeWeighten;
+}
+
+void MapBase::UseSearchQueue(SearchQueueType type)
+{
+	_searchQueueType = type;
+}
+
+void MapBase::UseSearchHeuristic(SearchHeuristicType type)
+{
+	_searchHeuristicType = type;
+}
+
+void MapBase::UseTieBreaking(SearchTieBreaking tieBreaking)
+{
+	_tieBreaking = tieBreaking;
+}
+
+void MapBase::UseClosedSet(bool enabled)
+{
+	_useClosedSet = enabled;
+}
+
+void MapBase::UseEdgeListBellmanFord(bool enabled)
+{
+	_useEdgeList = enabled;
+}
+
+void MapBase::UseSearchAlgorithm(SearchAlgorithm algorithm)
+{
+	_searchAlgorithm = algorithm;
+}
+
+void MapBase::UseHierarchicalSearch(int clusterSize)
+{
+	_hierarchicalClusterSize = clusterSize;
+
+	// Map is loaded already.
+	if (_vertexCells.GetSize() > 0)
+	{
+		_InitialiseHierarchicalSearch();
+	}
+}
+
+/// <summary>
+/// Builds hierarchical search for the loaded map if cluster size is set and the map has no negative cells.
+/// </summary>
+void MapBase::_InitialiseHierarchicalSearch()
+{
+	_hierarchicalSearch.Clear();
+
+	if (_hierarchicalClusterSize <= 0 || _isNegativeWeighten)
+	{
+		return;
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	_hierarchicalSearch.Build(_terrain, _vertexCells, _hierarchicalClusterSize, _minWeight, _maxWeight);
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+	std::cout << "Hierarchical search: " << _hierarchicalSearch.GetNodesNumber() << " entrance nodes and " <<
+		_hierarchicalSearch.GetArcsNumber() << " arcs over " << _hierarchicalClusterSize << "x" << _hierarchicalClusterSize <<
+		" clusters take " << _hierarchicalSearch.GetMemoryUsage() / 1024 << " KB, built in " << elapsed.count() << " ms." << std::endl;
+}
+
+/// <summary>
+/// Both cells are moveable and connected, and the start is not a negative cell.
+/// </summary>
+bool MapBase::IsReachable(int x1, int y1, int x2, int y2) const
+{
+	// Negative cells have arcs into them only: a path can end in one but never start from it.
+	if (_isNegativeWeighten && (x1 != x2 || y1 != y2) && _terrain.GetCost(_terrain.Index(y1, x1)) < 0)
+	{
+		return false;
+	}
+
+	if (!_components.IsBuilt())
+	{
+		return GetVertexId(x1, y1) >= 0 && GetVertexId(x2, y2) >= 0;
+	}
+
+	return _components.IsConnected(GetVertexId(x1, y1), GetVertexId(x2, y2));
+}
+
+/// <summary>
+/// Labels connected components of the graph used for searches and logs their sizes.
+/// Enclosed yards and pockets show up as small components: paths into them are rejected without a search.
+/// </summary>
+void MapBase::_InitialiseComponents()
+{
+	_components.Clear();
+
+	if (_vertexCells.GetSize() == 0 || !_IsGraphBuilt())
+	{
+		return;
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	if (_IsImplicitGraphUsed())
+	{
+		_components.Build(_gridGraph);
+	}
+	else
+	{
+		_components.Build(_adjacencyList);
+	}
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+	// Sizes of the largest components, the rest are summed up.
+	const int printedComponents = 8;
+	std::cout << "Connected components: " << _components.GetComponentsNumber() << ", vertices in them:";
+	for (int component = 0; component < _components.GetComponentsNumber() && component < printedComponents; component++)
+	{
+		std::cout << " " << _components.GetComponentSize(component);
+	}
+
+	if (_components.GetComponentsNumber() > printedComponents)
+	{
+		int restVertices = 0;
+		for (int component = printedComponents; component < _components.GetComponentsNumber(); component++)
+		{
+			restVertices += _components.GetComponentSize(component);
+		}
+
+		std::cout << " and " << restVertices << " in " << _components.GetComponentsNumber() - printedComponents << " smaller ones";
+	}
+
+	std::cout << ". Labelled in " << elapsed.count() << " ms." << std::endl;
+}
+
+void MapBase::UseContractionHierarchy(bool enabled)
+{
+	_useContractionHierarchy = enabled;
+
+	// Built right away if the graph is ready, otherwise InitialiseGraph builds it.
+	_InitialiseContractionHierarchy();
+}
+
+/// <summary>
+/// Builds contraction hierarchy of the graph used for searches if it is enabled and the map has no negative cells.
+/// </summary>
+void MapBase::_InitialiseContractionHierarchy()
+{
+	_contractionHierarchy.Clear();
+
+	if (!_useContractionHierarchy || _isNegativeWeighten || _vertexCells.GetSize() == 0)
+	{
+		return;
+	}
+
+	if (!_IsGraphBuilt())
+	{
+		return; // InitialiseGraph builds it later.
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	if (_IsImplicitGraphUsed())
+	{
+		_contractionHierarchy.Build(_gridGraph);
+	}
+	else
+	{
+		_contractionHierarchy.Build(_adjacencyList);
+	}
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+	std::cout << "Contraction hierarchy: " << _contractionHierarchy.GetArcsNumber() << " arcs including " <<
+		_contractionHierarchy.GetShortcutsNumber() << " shortcuts take " << _contractionHierarchy.GetMemoryUsage() / 1024 <<
+		" KB, built in " << elapsed.count() << " ms." << std::endl;
+}
+
+void MapBase::UseLandmarks(int landmarksNumber, LandmarkSelection selection)
+{
+	_landmarksNumber = landmarksNumber;
+	_landmarkSelection = selection;
 
-	_edgesList.clear();
+	// Built right away if the graph is ready, otherwise InitialiseGraph builds it.
+	_InitialiseLandmarks();
+}
+
+/// <summary>
+/// Loads landmark tables saved for the map or computes and saves them, if landmarks are enabled and the map has no negative cells.
+/// Maps stay the same for a long time, so the preprocessing is paid once per map version.
+/// </summary>
+void MapBase::_InitialiseLandmarks()
+{
+	_landmarkTable.Clear();
+
+	if (_landmarksNumber <= 0 || _isNegativeWeighten || _vertexCells.GetSize() == 0 || !_IsGraphBuilt())
+	{
+		return;
+	}
+
+	std::string filepath = _mapFilepath.empty() ? std::string() : _mapFilepath + LANDMARKS_EXTENSION;
+	uint64_t terrainHash = _terrain.GetHash();
+
+	if (!filepath.empty() && _landmarkTable.Load(filepath, terrainHash, _verticesNumber, _landmarksNumber, _landmarkSelection))
+	{
+		std::cout << "Landmarks loaded from " << filepath << ": " << _landmarkTable.GetLandmarksNumber() << " landmarks take " <<
+			_landmarkTable.GetMemoryUsage() / 1024 << " KB." << std::endl;
+		return;
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	if (_IsImplicitGraphUsed())
+	{
+		_landmarkTable.Build(_gridGraph, _landmarksNumber, _landmarkSelection);
+	}
+	else
+	{
+		_landmarkTable.Build(_adjacencyList, _landmarksNumber, _landmarkSelection);
+	}
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+	std::cout << "Landmarks: " << _landmarkTable.GetLandmarksNumber() << " landmarks take " << _landmarkTable.GetMemoryUsage() / 1024 <<
+		" KB, built in " << elapsed.count() << " ms." << std::endl;
+
+	if (!filepath.empty())
+	{
+		_landmarkTable.Save(filepath, terrainHash);
+	}
+}
+
+void MapBase::UsePathDatabase(bool enabled, const std::vector<Coordinate>& sources)
+{
+	_usePathDatabase = enabled;
+	_pathDatabaseSources = sources;
+
+	// Built right away if the graph is ready, otherwise InitialiseGraph builds it.
+	_InitialisePathDatabase();
+}
+
+/// <summary>
+/// Pickup and dropoff cells of the orders section, the most frequent first, cellsNumber at most.
+/// </summary>
+std::vector<Coordinate> MapBase::GetFrequentOrderCells(int cellsNumber) const
+{
+	std::map<Coordinate, int> frequencies;
+
+	OrderReader reader(_orders);
+	std::vector<Order> orders;
+	while (reader.NextIteration(orders))
+	{
+		for (const Order& order : orders)
+		{
+			frequencies[order.GetPickupLocation()]++;
+			frequencies[order.GetDropoffLocation()]++;
+		}
+	}
+
+	std::vector<std::pair<int, Coordinate>> cells;
+	cells.reserve(frequencies.size());
+	for (const auto& [cell, frequency] : frequencies)
+	{
+		cells.push_back({ -frequency, cell });
+	}
+
+	std::sort(cells.begin(), cells.end());
+
+	std::vector<Coordinate> frequentCells;
+	for (size_t i = 0; i < cells.size() && (int)i < cellsNumber; i++)
+	{
+		frequentCells.push_back(cells[i].second);
+	}
+
+	return frequentCells;
+}
+
+/// <summary>
+/// Loads path database saved for the map and the sources or computes and saves it, if it is enabled and the map has no negative cells.
+/// Rows of every source are computed once per map version: this is what makes the whole table affordable.
+/// </summary>
+void MapBase::_InitialisePathDatabase()
+{
+	_pathDatabase.Clear();
+
+	if (!_usePathDatabase || _isNegativeWeighten || _vertexCells.GetSize() == 0 || !_IsGraphBuilt())
+	{
+		return;
+	}
+
+	std::vector<int> sourceIds;
+	for (const auto& [x, y] : _pathDatabaseSources)
+	{
+		int vertexId = GetVertexId(x, y);
+		if (vertexId >= 0)
+		{
+			sourceIds.push_back(vertexId);
+		}
+	}
+
+	if (!_pathDatabaseSources.empty() && sourceIds.empty())
+	{
+		return; // None of the sources is moveable: nothing to compute, rather than every vertex.
+	}
+
+	std::string filepath = _mapFilepath.empty() ? std::string() : _mapFilepath + PATH_DATABASE_EXTENSION;
+	uint64_t terrainHash = _terrain.GetHash();
+
+	if (!filepath.empty() && _pathDatabase.Load(filepath, terrainHash, _verticesNumber, sourceIds))
+	{
+		std::cout << "Path database loaded from " << filepath << ": " << _pathDatabase.GetSourcesNumber() << " sources, " <<
+			_pathDatabase.GetRunsNumber() << " runs take " << _pathDatabase.GetMemoryUsage() / 1024 << " KB." << std::endl;
+		return;
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	if (_IsImplicitGraphUsed())
+	{
+		_pathDatabase.Build(_gridGraph, _vertexCells, _width, sourceIds);
+	}
+	else
+	{
+		_pathDatabase.Build(_adjacencyList, _vertexCells, _width, sourceIds);
+	}
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+	std::cout << "Path database: " << _pathDatabase.GetSourcesNumber() << " sources, " << _pathDatabase.GetRunsNumber() <<
+		" runs take " << _pathDatabase.GetMemoryUsage() / 1024 << " KB, built in " << elapsed.count() << " ms." << std::endl;
+
+	if (!filepath.empty())
+	{
+		_pathDatabase.Save(filepath, terrainHash);
+	}
+}
+
+bool MapBase::_IsGraphBuilt() const
+{
+	int graphVerticesNumber = _IsImplicitGraphUsed() ? _gridGraph.GetVerticesNumber() : _adjacencyList.GetVerticesNumber();
+
+	return _vertexCells.GetSize() > 0 && graphVerticesNumber == _verticesNumber;
+}
+
+SearchAlgorithm MapBase::_GetSearchAlgorithm() const
+{
+	// Path database covers its sources only (see GetPath): the rest of the queries are searched as with Auto.
+	SearchAlgorithm searchAlgorithm = _searchAlgorithm == SearchAlgorithm::PathDatabase ? SearchAlgorithm::Auto : _searchAlgorithm;
+
+	// Contraction hierarchy finds exact paths, so it goes before hierarchical search.
+	if (searchAlgorithm == SearchAlgorithm::Auto && _contractionHierarchy.IsBuilt())
+	{
+		return SearchAlgorithm::ContractionHierarchy;
+	}
+
+	if (searchAlgorithm == SearchAlgorithm::Auto && _hierarchicalSearch.IsBuilt())
+	{
+		return SearchAlgorithm::Hierarchical;
+	}
+
+	if (searchAlgorithm == SearchAlgorithm::Auto ||
+		((searchAlgorithm == SearchAlgorithm::JumpPointSearch || searchAlgorithm == SearchAlgorithm::BidirectionalBFS) && _isWeighten) ||
+		(searchAlgorithm == SearchAlgorithm::Hierarchical && !_hierarchicalSearch.IsBuilt()) ||
+		(searchAlgorithm == SearchAlgorithm::ContractionHierarchy && !_contractionHierarchy.IsBuilt()))
+	{
+		return _isWeighten ? SearchAlgorithm::BidirectionalAStar : SearchAlgorithm::JumpPointSearch;
+	}
+
+	return searchAlgorithm;
+}
+
+SearchQueueType MapBase::_GetSearchQueueType() const
+{
+	if (_searchQueueType != SearchQueueType::Auto && _searchQueueType != SearchQueueType::Buckets)
+	{
+		return _searchQueueType;
+	}
+
+	// Bucket queue scans up to max weight buckets per pop and needs them all allocated.
+	return _maxWeight <= BUCKET_QUEUE_MAX_WEIGHT ? SearchQueueType::Buckets : SearchQueueType::RadixHeap;
+}
+
+/// <summary>
+/// Highest cost of a step into a moveable cell.
+/// </summary>
+int MapBase::_GetMaxWeight() const
+{
+	int maxWeight = 1;
+	for (size_t vertexId = 0; vertexId < _vertexCells.GetSize(); vertexId++)
+	{
+		maxWeight = std::max(maxWeight, _terrain.GetCost(_vertexCells[vertexId]));
+	}
+
+	return maxWeight;
+}
+
+/// <summary>
+/// Lowest cost of a step into a moveable cell, 0 if some cells are negative.
+/// </summary>
+int MapBase::_GetMinWeight() const
+{
+	if (_vertexCells.GetSize() == 0)
+	{
+		return 1;
+	}
+
+	int minWeight = INF;
+	for (size_t vertexId = 0; vertexId < _vertexCells.GetSize(); vertexId++)
+	{
+		minWeight = std::min(minWeight, _terrain.GetCost(_vertexCells[vertexId]));
+	}
+
+	return std::max(minWeight, 0);
 }
 
 void MapBase::Draw() const
@@ -38,9 +675,9 @@ void MapBase::Draw() const
 	//Color graphColor = Color::Cyan;
 	//for (int i = 0; i < _verticesNumber; ++i)
 	//{
-	//	for (const auto& cell : _adjacencyList[i])
+	//	for (const auto& arc : _adjacencyList[i])
 	//	{
-	//		cell->SetColor(graphColor);
+	//		_DrawTile(x, y, graphColor);
 	//	}
 	//}
 
@@ -54,9 +691,9 @@ void MapBase::Draw() const
 		{
 			for (int i = _visibleTopLeftX; i < _visibleBottomRightX; i++)
 			{
-				int index = (_grid[j][i]->GetY() * _width + _grid[j][i]->GetX());
+				int index = _terrain.Index(j, i);
 
-				sf::Color color = _grid[j][i]->GetColor();
+				sf::Color color = _GetCellColor(index);
 				pixels[index * 4] = color.r;
 				pixels[index * 4 + 1] = color.g;
 				pixels[index * 4 + 2] = color.b;
@@ -71,6 +708,8 @@ void MapBase::Draw() const
 		sprite.setTexture(texture);
 		sprite.setScale(cellSize, cellSize);
 		_window.draw(sprite);
+
+		delete[] pixels;
 	}
 	else
 	{
@@ -78,12 +717,66 @@ void MapBase::Draw() const
 		{
 			for (int i = _visibleTopLeftX; i < _visibleBottomRightX; i++)
 			{
-				_grid[j][i]->Draw(_window, _scaleFactor);
+				_DrawTile(i, j, _GetCellColor(_terrain.Index(j, i)));
 			}
 		}
 	}
 }
 
+sf::Color MapBase::_GetCellColor(int index) const
+{
+	auto highlighted = _highlightedCells.find(index);
+	if (highlighted != _highlightedCells.end())
+	{
+		return highlighted->second;
+	}
+
+	switch (_terrain.GetSymbol(index))
+	{
+	case FREE_CELL:
+		return sf::Color(34, 177, 76);
+	case BLOCK_CELL:
+		return sf::Color::Black;
+	case GRASS_CELL:
+		return sf::Color(168, 168, 168);
+	case WATER_CELL:
+		return sf::Color::Cyan;
+	}
+
+	return sf::Color();
+}
+
+void MapBase::_DrawTile(int x, int y, sf::Color color) const
+{
+	float cellSize = _scaleFactor * (float)DEFAULT_SQUARE_TILE_SIZE;
+
+	if (_shadow)
+	{
+		sf::RectangleShape shadow;
+		shadow.setSize(sf::Vector2f(cellSize, cellSize));
+		shadow.setPosition(sf::Vector2f(x * cellSize, y * cellSize));
+		Color c = color;
+		c.b += 100;
+		shadow.setFillColor(c);
+		_window.draw(shadow);
+	}
+
+	sf::RectangleShape tile;
+
+	if (cellSize > 5)
+	{
+		tile.setSize(sf::Vector2f(cellSize - 5, cellSize - 5));
+	}
+	else
+	{
+		tile.setSize(sf::Vector2f(cellSize, cellSize));
+	}
+
+	tile.setPosition(sf::Vector2f(x * cellSize, y * cellSize));
+	tile.setFillColor(color);
+	_window.draw(tile);
+}
+
 void MapBase::PrintMapSVG(const std::string& filename) const
 {
 	std::ofstream svgfile(filename + ".svg");
@@ -106,48 +799,91 @@ void MapBase::PrintMapSVG(const std::string& filename) const
 		<< "\" width=\"" << xresolution << "\" height=\"" << yresolution
 		<< "\" fill=\"white\"/>" << std::endl;
 
-	for (int i = 0; i < _grid.size(); i++)
+	for (int y = 0; y < _terrain.GetHeight(); y++)
 	{
-		for (const auto& cell : _grid[i])
+		for (int x = 0; x < _terrain.GetWidth(); x++)
 		{
-			if (cell->GetSymbol() == '.') // Alternatively and better: to convert cell->Color -> into STRING
-				svgfile << cell->SVGPrint("green") << "\n";
-			else
-				svgfile << cell->SVGPrint("black") << "\n";
+			// Alternatively and better: to convert cell Color -> into STRING
+			std::string color = _terrain.GetSymbol(_terrain.Index(y, x)) == FREE_CELL ? "green" : "black";
+
+			svgfile << "<rect x=\"" << x * DEFAULT_SQUARE_TILE_SIZE << "\" "
+				<< "y=\"" << y * DEFAULT_SQUARE_TILE_SIZE << "\" "
+				<< "width=\"" << DEFAULT_SQUARE_TILE_SIZE << "\" "
+				<< "height=\"" << DEFAULT_SQUARE_TILE_SIZE << "\" "
+				<< "stroke=\"" << color << "\" "
+				<< "fill=\"" << color << "\" />\n";
 		}
 	}
 
-	//for (int i = 0; i < _verticesNumber; ++i)
-	//{
-	//	for (const auto& cell : _adjacencyList[i])
-	//	{
-	//		svgfile << cell->SVGPrint("cyan") << "\n";
-	//	}
-	//}
-
 	svgfile << "</g>" << std::endl;
 	svgfile << "</svg>" << std::endl;
 }
 
-std::shared_ptr<Cell> MapBase::GetCellFromGrid(int row, int column) const
+void MapBase::SetCellColor(int x, int y, const sf::Color& color)
+{
+	_highlightedCells[_terrain.Index(y, x)] = color;
+}
+
+int MapBase::GetVertexId(int x, int y) const
 {
-	return _grid[row][column];
+	return _terrain.GetVertexId(_terrain.Index(y, x));
 }
 
-std::shared_ptr<Cell> MapBase::GetFirstMoveableCell() const
+Coordinate MapBase::GetVertexCoordinate(int vertexId) const
 {
-	if (_moveableCells.size() > 0)
-		return _moveableCells[0];
+	int index = _vertexCells[vertexId];
+	int y = index / _terrain.GetWidth();
+	int x = index - y * _terrain.GetWidth();
+
+	return std::make_tuple(x, y);
+}
+
+/// <summary>
+/// Sum of the step costs along the path: cost of every cell except the first one.
+/// </summary>
+int MapBase::GetPathCost(const std::vector<Coordinate>& path) const
+{
+	int cost = 0;
+	for (size_t i = 1; i < path.size(); i++)
+	{
+		int x, y;
+		std::tie(x, y) = path[i];
+		cost += _terrain.GetCost(_terrain.Index(y, x));
+	}
+
+	return cost;
+}
+
+Coordinate MapBase::GetFirstMoveableCell() const
+{
+	if (_vertexCells.GetSize() > 0)
+		return GetVertexCoordinate(0);
+
+	return std::make_tuple(-1, -1);
+}
+
+std::vector<Coordinate> MapBase::_ToCoordinates(const std::vector<int>& vertexIds) const
+{
+	std::vector<Coordinate> result;
+	result.reserve(vertexIds.size());
+
+	for (auto& v : vertexIds)
+	{
+		if (v >= 0 && (size_t)v < _vertexCells.GetSize())
+			result.push_back(GetVertexCoordinate(v));
+		else
+			return {};
+	}
 
-	return NULL;
+	return result;
 }
 
 void MapBase::UpdateVisiblePart(float topLeftX, float topLeftY, float bottomRightX, float bottomRightY)
 {
-	if (topLeftX >= 0 && topLeftX <= _grid.size() &&
-		topLeftY >= 0 && topLeftY <= _grid.size() &&
-		bottomRightX >= 0 && bottomRightX <= _grid.size() &&
-		bottomRightY >= 0 && bottomRightY <= _grid.size())
+	if (topLeftX >= 0 && topLeftX <= _terrain.GetWidth() &&
+		topLeftY >= 0 && topLeftY <= _terrain.GetHeight() &&
+		bottomRightX >= 0 && bottomRightX <= _terrain.GetWidth() &&
+		bottomRightY >= 0 && bottomRightY <= _terrain.GetHeight())
 	{
 		_visibleTopLeftX = topLeftX;
 		_visibleTopLeftY = topLeftY;
@@ -0,0 +1,65 @@
+#include "mapreader.h"
+#include <charconv>
+
+namespace
+{
+	inline bool IsWhitespace(char c)
+	{
+		return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+	}
+}
+
+MapReader::MapReader(std::string_view content) : _content(content), _position(0)
+{
+}
+
+/// <summary>
+/// Reads next whitespace separated integer.
+/// </summary>
+bool MapReader::ReadInt(int& value)
+{
+	std::string_view token;
+	if (!_ReadToken(token))
+	{
+		return false;
+	}
+
+	auto result = std::from_chars(token.data(), token.data() + token.size(), value);
+
+	return result.ec == std::errc() && result.ptr == token.data() + token.size();
+}
+
+/// <summary>
+/// Reads next whitespace separated token (e.g. row of the grid) as a view into the content.
+/// </summary>
+bool MapReader::ReadRow(std::string_view& row)
+{
+	return _ReadToken(row);
+}
+
+std::string_view MapReader::GetRest() const
+{
+	return _content.substr(_position);
+}
+
+bool MapReader::_ReadToken(std::string_view& token)
+{
+	const char* data = _content.data();
+	size_t size = _content.size();
+
+	while (_position < size && IsWhitespace(data[_position]))
+	{
+		++_position;
+	}
+
+	size_t start = _position;
+
+	while (_position < size && !IsWhitespace(data[_position]))
+	{
+		++_position;
+	}
+
+	token = std::string_view(data + start, _position - start);
+
+	return !token.empty();
+}
@@ -0,0 +1,39 @@
+#ifndef MAPREADER_H
+#define MAPREADER_H
+
+#include "common.h"
+#include <string_view>
+
+/// <summary>
+/// Reads map files straight from the memory mapped content. Rows are returned as views into the mapping,
+/// so nothing is copied until the caller puts symbols into the terrain.
+/// </summary>
+class MapReader
+{
+public:
+	MapReader(std::string_view content);
+
+	/// <summary>
+	/// Reads next whitespace separated integer.
+	/// </summary>
+	bool ReadInt(int& value);
+
+	/// <summary>
+	/// Reads next whitespace separated token (e.g. row of the grid) as a view into the content.
+	/// </summary>
+	bool ReadRow(std::string_view& row);
+
+	/// <summary>
+	/// Part of the content that was not consumed yet, e.g. the orders section after the last grid row.
+	/// </summary>
+	std::string_view GetRest() const;
+
+private:
+	bool _ReadToken(std::string_view& token);
+
+private:
+	std::string_view _content;
+	size_t _position;
+};
+
+#endif
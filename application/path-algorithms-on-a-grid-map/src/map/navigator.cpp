@@ -1,72 +1,43 @@
 #include "navigator.h"
+#include "orderreader.h"
 #include <chrono>
 
 Navigator::Navigator() : 
 	_tasksLoaded(false),
-	_currentOrder(-1)
-	//_nextIteration(-1),
-	//_lastFinishedIteration(-1),
-	//_currentOrderWithinIteration(-1)
+	_totalIterations(0),
+	_totalOrders(0),
+	_currentOrder(0)
 {
     _rover = make_shared<Rover>();
 }
 
-bool Navigator::LoadTasks(const std::string& filepath)
+bool Navigator::LoadTasks(std::string_view orders)
+{
+	return LoadTasks(std::make_unique<OrderReader>(orders));
+}
+
+/// <summary>
+/// Takes orders from any source, e.g. binary order log.
+/// </summary>
+bool Navigator::LoadTasks(std::unique_ptr<OrderSource> orderSource)
 {
 	if (_tasksLoaded)
 	{
 		return _tasksLoaded;
 	}
 
-	Color orderColor = Color::Red;
-	ifstream readstream;
-	readstream.open(filepath);
-
-	if (readstream)
-	{
-		string line;
-		int mapSize = 0;
-		int maxTips = 0;
-		int roverCost = 0;
-		readstream >> mapSize >> maxTips >> roverCost;
-
-		for (int i = 0; i < mapSize; i++)
-		{
-			readstream >> line;
-		}
+	_orderSource = std::move(orderSource);
+	_totalIterations = _orderSource->GetTotalIterations();
+	_totalOrders = _orderSource->GetTotalOrders();
 
-		readstream >> _totalIterations >> _totalOrders;
-
-		_orders.clear();
-		for (int i = 0; i < _totalIterations; i++)
-		{
-			int newOrders = 0;
-			readstream >> newOrders;
-
-			while (newOrders-- > 0)
-			{
-				int r1, c1, r2, c2; // Rows and Columns
-				readstream >> r1 >> c1 >> r2 >> c2;
-
-				Order order(
-					c1 - 1, // Columns are X's
-					r1 - 1, // Rows are Y's
-					c2 - 1,
-					r2 - 1,
-					orderColor);
-
-				_orders.push_back(make_shared<Order>(order));
-			}
-		}
-	}
-	readstream.close();
+	_iterationOrders.clear();
+	_currentOrder = 0;
 
 	_tasksLoaded = true;
 
 	return _tasksLoaded;
 }
 
-
 bool Navigator::IsReady()
 {
 	return _tasksLoaded && _map->IsReady();
@@ -76,9 +47,10 @@ void Navigator::SetMap(std::shared_ptr<MapBase> map)
 {
 	_map = map;
 
-	auto cell = _map->GetFirstMoveableCell();
+	int x, y;
+	std::tie(x, y) = _map->GetFirstMoveableCell();
 
-	InitRoverPosition(cell->GetX(), cell->GetY());
+	InitRoverPosition(x, y);
 }
 
 void Navigator::InitRoverPosition(int x, int y)
@@ -90,17 +62,22 @@ void Navigator::InitRoverPosition(int x, int y)
 void Navigator::Navigate()
 {
 	// Solve next task
-	if (_totalOrders > 0)
+	if (_orderSource)
 	{
-		if (_currentOrder == -1)
+		// Take next iteration when current one is over (iterations may have no orders at all).
+		while (_currentOrder >= _iterationOrders.size() && _orderSource->NextIteration(_iterationOrders))
+		{
 			_currentOrder = 0;
+		}
 
-		// Solve order
-        _RunDelivery(_orders[_currentOrder]);
-
-		// Mark solved
+		if (_currentOrder < _iterationOrders.size())
+		{
+			// Solve order
+			_RunDelivery(_iterationOrders[_currentOrder]);
 
-		// Increase _currentOrder
+			// Mark solved
+			++_currentOrder;
+		}
 	}
 
 	// Merge results into map
@@ -110,10 +87,10 @@ void Navigator::Navigate()
 		_map->Draw();
 }
 
-void Navigator::_RunDelivery(shared_ptr<Order> order)
+void Navigator::_RunDelivery(const Order& order)
 {
 	int x1, y1;
-	std::tie(x1, y1) = order->GetPickupLocation();
+	std::tie(x1, y1) = order.GetPickupLocation();
 
 	///////////////////////////////////////////////////////////////////// Start chrono
 	std::chrono::time_point<std::chrono::system_clock> start = std::chrono::system_clock::now();
@@ -145,38 +122,44 @@ void Navigator::_RunDelivery(shared_ptr<Order> order)
 
 	for (auto& v : path1)
 	{
-		if (v->GetX() == x1 && v->GetY() == y1)
+		int x, y;
+		std::tie(x, y) = v;
+
+		if (x == x1 && y == y1)
 		{
-			v->SetColor(goalColor);
+			_map->SetCellColor(x, y, goalColor);
 		}
-		else if (v->GetX() == _rover->PositionX && v->GetY() == _rover->PositionY)
+		else if (x == _rover->PositionX && y == _rover->PositionY)
 		{
-			v->SetColor(startColor);
+			_map->SetCellColor(x, y, startColor);
 		}
 		else
 		{
-			v->SetColor(pathColor);
+			_map->SetCellColor(x, y, pathColor);
 		}
 	}
 
 	// Find Path from Start Cell to End Cell
 	int x2, y2;
-	std::tie(x2, y2) = order->GetDropoffLocation();
+	std::tie(x2, y2) = order.GetDropoffLocation();
 	auto path2 = _map->GetPath(x1, y1, x2, y2);
 
 	for (auto& v : path2)
 	{
-		if (v->GetX() == x2 && v->GetY() == y2)
+		int x, y;
+		std::tie(x, y) = v;
+
+		if (x == x2 && y == y2)
 		{
-			v->SetColor(goalColor);
+			_map->SetCellColor(x, y, goalColor);
 		}
-		else if (v->GetX() == x1 && v->GetY() == y1)
+		else if (x == x1 && y == y1)
 		{
-			v->SetColor(startColor);
+			_map->SetCellColor(x, y, startColor);
 		}
 		else
 		{
-			v->SetColor(pathColor);
+			_map->SetCellColor(x, y, pathColor);
 		}
 	}
 
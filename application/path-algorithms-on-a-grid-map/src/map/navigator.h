@@ -1,7 +1,7 @@
 #ifndef __Navigator_h__
 #define __Navigator_h__
 
-#include "order.h"
+#include "ordersource.h"
 #include "rover.h"
 #include "mapbase.h"
 
@@ -12,14 +12,22 @@ class Navigator
 public:
 	Navigator();
 
-	bool LoadTasks(const std::string& filepath);
+	/// <summary>
+	/// Loads orders from the orders section of the loaded map (see MapBase::GetOrders), so the map file is not read again.
+	/// </summary>
+	bool LoadTasks(std::string_view orders);
+
+	/// <summary>
+	/// Takes orders from any source, e.g. binary order log.
+	/// </summary>
+	bool LoadTasks(std::unique_ptr<OrderSource> orderSource);
 	void SetMap(std::shared_ptr<MapBase> map);
 	void InitRoverPosition(int x, int y);
 	void Navigate();
 	bool IsReady();
 
 private:
-	void _RunDelivery(shared_ptr<Order> order);
+	void _RunDelivery(const Order& order);
 
 private:
 	std::shared_ptr<MapBase> _map;
@@ -28,14 +36,11 @@ private:
 	bool _tasksLoaded;
 	int _totalIterations;
 	int _totalOrders;
-	vector<shared_ptr<Order>> _orders;
-	int _currentOrder;
-
-	// I don't need this complexity for now.
-	//vector<vector<Order>> _iterationsOrders;
-	//int _nextIteration;
-	//int _lastFinishedIteration;
-	//int _currentOrderWithinIteration;
+
+	// Orders are streamed: only orders of the current iteration are in memory.
+	std::unique_ptr<OrderSource> _orderSource;
+	vector<Order> _iterationOrders;
+	size_t _currentOrder;
 };
 
 #endif __Navigator_h__
\ No newline at end of file
@@ -1,24 +1,23 @@
 #ifndef __Order_h__
 #define __Order_h__
 
-#include "cellbase.h"
 #include "coordinate.h"
+#include <cstdint>
 
-class Order : public CellBase
+/// <summary>
+/// Delivery order: pickup and dropoff cells (0-based, X is column, Y is row) and the iteration it arrived at.
+/// Plain 12 bytes value, so millions of orders never turn into millions of heap objects.
+/// </summary>
+struct Order
 {
-public:
-	Order(int x1, int y1, int x2, int y2, Color& color);
-	virtual std::string SVGPrint(const std::string& color) const;
-	virtual void Draw(sf::RenderWindow& window, float scaleFactor) const;
-	virtual void SetColor(sf::Color& color);
+	uint16_t X1;
+	uint16_t Y1;
+	uint16_t X2;
+	uint16_t Y2;
+	int32_t Iteration;
 
-	Coordinate GetPickupLocation() const;
-	Coordinate GetDropoffLocation() const;
-
-private:
-	int _x1, _y1;
-	int _x2, _y2;
-	Color& _color;
+	Coordinate GetPickupLocation() const { return std::make_tuple((int)X1, (int)Y1); }
+	Coordinate GetDropoffLocation() const { return std::make_tuple((int)X2, (int)Y2); }
 };
 
 #endif __Order_h__
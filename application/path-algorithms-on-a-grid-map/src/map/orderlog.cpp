@@ -0,0 +1,188 @@
+#include "orderlog.h"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	/// <summary>
+	/// Section of count elements of type T at offset lies within the file and is aligned for its elements.
+	/// </summary>
+	template <typename T>
+	bool IsSectionInFile(uint64_t offset, uint64_t count, size_t fileSize)
+	{
+		return offset <= fileSize && offset % alignof(T) == 0 && count <= (fileSize - offset) / sizeof(T);
+	}
+}
+
+OrderLog::OrderLog() :
+	_header(nullptr),
+	_orders(nullptr),
+	_index(nullptr),
+	_nextIteration(0)
+{
+}
+
+/// <summary>
+/// Drains source into the binary order log file. Only the index of iterations is kept in memory.
+/// </summary>
+bool OrderLog::Write(const std::string& filepath, OrderSource& source)
+{
+	std::ofstream output(filepath, std::ios::binary | std::ios::trunc);
+	if (!output)
+	{
+		std::cerr << "Error opening " << filepath << " for writing." << std::endl;
+		return false;
+	}
+
+	auto align = [](uint64_t offset) { return (offset + 7) & ~(uint64_t)7; };
+	static const char padding[8] = {};
+
+	OrderLogHeader header = {};
+	memcpy(header.Magic, ORDER_LOG_MAGIC, sizeof(header.Magic));
+	header.Version = ORDER_LOG_VERSION;
+	header.TotalIterations = source.GetTotalIterations();
+	header.TotalOrders = source.GetTotalOrders();
+	header.OrdersOffset = align(sizeof(OrderLogHeader));
+
+	// Header is written again when the numbers are known.
+	output.write((const char*)&header, sizeof(header));
+	output.write(padding, header.OrdersOffset - sizeof(header));
+
+	std::vector<uint32_t> index(1, 0);
+	std::vector<Order> orders;
+	while (source.NextIteration(orders))
+	{
+		output.write((const char*)orders.data(), orders.size() * sizeof(Order));
+		index.push_back(index.back() + (uint32_t)orders.size());
+	}
+
+	header.IterationsNumber = (int32_t)index.size() - 1;
+	header.OrdersNumber = index.back();
+
+	uint64_t ordersEnd = header.OrdersOffset + (uint64_t)header.OrdersNumber * sizeof(Order);
+	header.IndexOffset = align(ordersEnd);
+	output.write(padding, header.IndexOffset - ordersEnd);
+	output.write((const char*)index.data(), index.size() * sizeof(uint32_t));
+
+	output.seekp(0);
+	output.write((const char*)&header, sizeof(header));
+
+	if (!output)
+	{
+		std::cerr << "Error writing " << filepath << "." << std::endl;
+		return false;
+	}
+
+	std::cout << "Order log saved to " << filepath << ": " << header.IterationsNumber << " iterations, " << header.OrdersNumber << " orders." << std::endl;
+
+	return true;
+}
+
+bool OrderLog::Open(const std::string& filepath)
+{
+	if (!_file.Open(filepath))
+	{
+		return false;
+	}
+
+	const char* data = _file.GetData();
+	const OrderLogHeader* header = (const OrderLogHeader*)data;
+
+	if (_file.GetSize() < sizeof(OrderLogHeader) ||
+		memcmp(header->Magic, ORDER_LOG_MAGIC, sizeof(header->Magic)) != 0 ||
+		header->Version != ORDER_LOG_VERSION)
+	{
+		std::cerr << filepath << " is not an order log of version " << ORDER_LOG_VERSION << "." << std::endl;
+		_file.Close();
+		return false;
+	}
+
+	// Iterations are served right from the mapping, so a truncated or damaged log must not point past its end
+	// and the index has to split the orders section into consecutive iterations.
+	size_t fileSize = _file.GetSize();
+	uint64_t ordersEnd = header->OrdersOffset + (uint64_t)header->OrdersNumber * sizeof(Order);
+
+	bool valid = header->IterationsNumber >= 0 &&
+		IsSectionInFile<Order>(header->OrdersOffset, header->OrdersNumber, fileSize) &&
+		IsSectionInFile<uint32_t>(header->IndexOffset, (uint64_t)header->IterationsNumber + 1, fileSize) &&
+		ordersEnd <= header->IndexOffset;
+
+	if (valid)
+	{
+		const uint32_t* index = (const uint32_t*)(data + header->IndexOffset);
+		valid = index[0] == 0 && index[header->IterationsNumber] == header->OrdersNumber &&
+			std::is_sorted(index, index + header->IterationsNumber + 1);
+	}
+
+	if (!valid)
+	{
+		std::cerr << filepath << " is damaged: its sections do not fit the file. Write it again from the text map." << std::endl;
+		_file.Close();
+		return false;
+	}
+
+	_header = header;
+	_orders = (const Order*)(data + header->OrdersOffset);
+	_index = (const uint32_t*)(data + header->IndexOffset);
+	_nextIteration = 0;
+
+	return true;
+}
+
+int OrderLog::GetTotalIterations() const
+{
+	return _header ? _header->TotalIterations : 0;
+}
+
+int OrderLog::GetTotalOrders() const
+{
+	return _header ? _header->TotalOrders : 0;
+}
+
+int OrderLog::GetIterationsNumber() const
+{
+	return _header ? _header->IterationsNumber : 0;
+}
+
+bool OrderLog::NextIteration(std::vector<Order>& orders)
+{
+	orders.clear();
+
+	if (_nextIteration >= GetIterationsNumber())
+	{
+		return false;
+	}
+
+	auto iterationOrders = GetIterationOrders(_nextIteration++);
+	orders.assign(iterationOrders.begin(), iterationOrders.end());
+
+	return true;
+}
+
+/// <summary>
+/// Makes NextIteration continue from the given iteration. O(1).
+/// </summary>
+bool OrderLog::Seek(int iteration)
+{
+	if (iteration < 0 || iteration > GetIterationsNumber())
+	{
+		return false;
+	}
+
+	_nextIteration = iteration;
+
+	return true;
+}
+
+/// <summary>
+/// Orders of the iteration right from the mapped file, without copying.
+/// </summary>
+std::span<const Order> OrderLog::GetIterationOrders(int iteration) const
+{
+	if (iteration < 0 || iteration >= GetIterationsNumber())
+	{
+		return {};
+	}
+
+	return std::span<const Order>(_orders + _index[iteration], _orders + _index[iteration + 1]);
+}
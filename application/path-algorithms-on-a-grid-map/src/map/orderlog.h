@@ -0,0 +1,81 @@
+#ifndef __OrderLog_h__
+#define __OrderLog_h__
+
+#include "ordersource.h"
+#include "MappedFile.h"
+#include <span>
+
+// Binary order log: the orders section of a text map converted into packed orders plus an index of iterations,
+// so replay can start from any iteration without parsing anything before it.
+//
+// Layout (sections start at 8-bytes aligned offsets stored in the header):
+//   OrderLogHeader
+//   orders   Order[OrdersNumber], all iterations one after another
+//   index    uint32_t[IterationsNumber + 1], number of the first order of every iteration
+
+const char ORDER_LOG_EXTENSION[] = ".orderlog";
+const char ORDER_LOG_MAGIC[8] = { 'O', 'R', 'D', 'E', 'R', 'L', 'O', 'G' };
+
+// Increase on any change of the layout, old files will be rejected.
+const uint32_t ORDER_LOG_VERSION = 1;
+
+struct OrderLogHeader
+{
+	char Magic[8];
+	uint32_t Version;
+
+	// T and D as declared by the text, and what was actually there.
+	int32_t TotalIterations;
+	int32_t TotalOrders;
+	int32_t IterationsNumber;
+	uint32_t OrdersNumber;
+	uint32_t Reserved;
+
+	uint64_t OrdersOffset;
+	uint64_t IndexOffset;
+};
+
+/// <summary>
+/// Order source over memory mapped binary order log. Seek to any iteration is O(1).
+/// </summary>
+class OrderLog : public OrderSource
+{
+public:
+	OrderLog();
+
+	/// <summary>
+	/// Drains source into the binary order log file. Only the index of iterations is kept in memory.
+	/// </summary>
+	static bool Write(const std::string& filepath, OrderSource& source);
+
+	bool Open(const std::string& filepath);
+
+	virtual int GetTotalIterations() const;
+	virtual int GetTotalOrders() const;
+
+	virtual bool NextIteration(std::vector<Order>& orders);
+
+	/// <summary>
+	/// Number of iterations actually stored in the log.
+	/// </summary>
+	int GetIterationsNumber() const;
+
+	/// <summary>
+	/// Makes NextIteration continue from the given iteration. O(1).
+	/// </summary>
+	bool Seek(int iteration);
+
+	/// <summary>
+	/// Orders of the iteration right from the mapped file, without copying.
+	/// </summary>
+	std::span<const Order> GetIterationOrders(int iteration) const;
+
+private:
+	MappedFile _file;
+	const OrderLogHeader* _header;
+	const Order* _orders;
+	const uint32_t* _index;
+	int _nextIteration;
+};
+
+#endif __OrderLog_h__
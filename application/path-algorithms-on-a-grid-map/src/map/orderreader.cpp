@@ -0,0 +1,61 @@
+#include "orderreader.h"
+
+OrderReader::OrderReader(std::string_view orders) :
+	_reader(orders),
+	_totalIterations(0),
+	_totalOrders(0),
+	_iteration(0),
+	_finished(false)
+{
+	if (!_reader.ReadInt(_totalIterations) || !_reader.ReadInt(_totalOrders))
+	{
+		_finished = true;
+	}
+}
+
+int OrderReader::GetTotalIterations() const
+{
+	return _totalIterations;
+}
+
+int OrderReader::GetTotalOrders() const
+{
+	return _totalOrders;
+}
+
+/// <summary>
+/// Replaces content of orders with orders of the next iteration. Returns false when there are no iterations left.
+/// </summary>
+bool OrderReader::NextIteration(std::vector<Order>& orders)
+{
+	orders.clear();
+
+	int newOrders = 0;
+	if (_finished || !_reader.ReadInt(newOrders))
+	{
+		_finished = true;
+		return false;
+	}
+
+	while (newOrders-- > 0)
+	{
+		int r1, c1, r2, c2; // Rows and Columns
+		if (!_reader.ReadInt(r1) || !_reader.ReadInt(c1) || !_reader.ReadInt(r2) || !_reader.ReadInt(c2))
+		{
+			// Declared number of orders is wrong: keep what was read and stop at the end of the text.
+			_finished = true;
+			break;
+		}
+
+		orders.push_back({
+			(uint16_t)(c1 - 1), // Columns are X's
+			(uint16_t)(r1 - 1), // Rows are Y's
+			(uint16_t)(c2 - 1),
+			(uint16_t)(r2 - 1),
+			_iteration });
+	}
+
+	++_iteration;
+
+	return true;
+}
@@ -0,0 +1,29 @@
+#ifndef __OrderReader_h__
+#define __OrderReader_h__
+
+#include "ordersource.h"
+#include "mapreader.h"
+
+/// <summary>
+/// Reads orders section of the text map (T, D, then for every iteration: k and k lines "r1 c1 r2 c2")
+/// lazily, one iteration per call. Stops when the text ends, whatever T and D say.
+/// </summary>
+class OrderReader : public OrderSource
+{
+public:
+	OrderReader(std::string_view orders);
+
+	virtual int GetTotalIterations() const;
+	virtual int GetTotalOrders() const;
+
+	virtual bool NextIteration(std::vector<Order>& orders);
+
+private:
+	MapReader _reader;
+	int _totalIterations;
+	int _totalOrders;
+	int _iteration;
+	bool _finished;
+};
+
+#endif __OrderReader_h__
@@ -0,0 +1,26 @@
+#ifndef __OrderSource_h__
+#define __OrderSource_h__
+
+#include "order.h"
+
+/// <summary>
+/// Stream of orders, consumed one iteration at a time. Memory does not depend on the total number of orders.
+/// </summary>
+class OrderSource
+{
+public:
+	virtual ~OrderSource() {}
+
+	/// <summary>
+	/// T and D as declared by the source. Files may lie about them, so they are for information only.
+	/// </summary>
+	virtual int GetTotalIterations() const = 0;
+	virtual int GetTotalOrders() const = 0;
+
+	/// <summary>
+	/// Replaces content of orders with orders of the next iteration. Returns false when there are no iterations left.
+	/// </summary>
+	virtual bool NextIteration(std::vector<Order>& orders) = 0;
+};
+
+#endif __OrderSource_h__
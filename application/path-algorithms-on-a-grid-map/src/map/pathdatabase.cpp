@@ -0,0 +1,506 @@
+#include "pathdatabase.h"
+#include "searchqueue.h"
+#include "common.h"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <thread>
+
+namespace
+{
+	/// <summary>
+	/// Position of the cell along the Hilbert curve filling the size x size square (size is a power of 2).
+	/// </summary>
+	uint64_t GetHilbertIndex(int size, int x, int y)
+	{
+		uint64_t index = 0;
+		for (int half = size / 2; half > 0; half /= 2)
+		{
+			int rx = (x & half) > 0;
+			int ry = (y & half) > 0;
+			index += (uint64_t)half * half * ((3 * rx) ^ ry);
+
+			// Rotates the quadrant, so the curve inside it starts where the previous quadrant ends.
+			if (ry == 0)
+			{
+				if (rx == 1)
+				{
+					x = size - 1 - x;
+					y = size - 1 - y;
+				}
+
+				std::swap(x, y);
+			}
+		}
+
+		return index;
+	}
+
+	/// <summary>
+	/// Sorted vertex ids of the sources without duplicates, every vertex if there are none.
+	/// </summary>
+	std::vector<int32_t> GetSources(const std::vector<int>& sourceIds, int verticesNumber)
+	{
+		std::vector<int32_t> sources;
+		if (sourceIds.empty())
+		{
+			sources.resize(verticesNumber);
+			std::iota(sources.begin(), sources.end(), 0);
+			return sources;
+		}
+
+		for (int sourceId : sourceIds)
+		{
+			if (sourceId >= 0 && sourceId < verticesNumber)
+			{
+				sources.push_back(sourceId);
+			}
+		}
+
+		std::sort(sources.begin(), sources.end());
+		sources.erase(std::unique(sources.begin(), sources.end()), sources.end());
+
+		return sources;
+	}
+}
+
+PathDatabase::PathDatabase() : _rows(PathDatabaseRows::FirstMoves)
+{
+}
+
+void PathDatabase::Clear()
+{
+	_ranks.Clear();
+	_ranks.ShrinkToFit();
+	_neighbours.Clear();
+	_neighbours.ShrinkToFit();
+	_sources.Clear();
+	_sources.ShrinkToFit();
+	_rowOffsets.Clear();
+	_rowOffsets.ShrinkToFit();
+	_runs.Clear();
+	_runs.ShrinkToFit();
+	_sourceRows.clear();
+	_sourceRows.shrink_to_fit();
+	_file.Close();
+}
+
+size_t PathDatabase::GetMemoryUsage() const
+{
+	return (_ranks.GetSize() + _neighbours.GetSize() + _sources.GetSize()) * sizeof(int32_t) +
+		_rowOffsets.GetSize() * sizeof(int64_t) + _runs.GetSize() * sizeof(uint32_t) + _sourceRows.capacity() * sizeof(int32_t);
+}
+
+/// <summary>
+/// Every source runs Dijkstra over the whole graph, then its moves are compressed in the order of ranks.
+/// Grids have lots of equally short paths, so a target may take any of its optimal moves: a run goes on
+/// while some move is optimal for all of its targets. The source itself may take any move as well.
+/// Optimal moves are collected while arcs are relaxed: the first move of the target is any first move
+/// of its parents on the shortest paths, its move in the tree is the direction to any of them.
+/// Zero weight arcs add no alternatives, so walks never go round in circles. O(sources * (E + V) * log(V)).
+/// </summary>
+void PathDatabase::_Build(const Graph& graph, const FlatArray<int32_t>& vertexCells, int width, const std::vector<int>& sourceIds)
+{
+	Clear();
+
+	int verticesNumber = graph.GetVerticesNumber();
+	if (verticesNumber <= 0 || verticesNumber >= (1 << (32 - PATH_DATABASE_MOVE_BITS)))
+	{
+		return;
+	}
+
+	std::vector<int32_t> sources = GetSources(sourceIds, verticesNumber);
+
+	// Chains of first moves need rows of every vertex, the rest of the tables get trees.
+	_rows = sourceIds.empty() ? PathDatabaseRows::FirstMoves : PathDatabaseRows::Trees;
+
+	std::vector<uint8_t> arcDirections;
+	if (!_BuildNeighbours(graph, vertexCells, width, arcDirections))
+	{
+		std::cerr << "Path database needs arcs between adjacent cells only." << std::endl;
+		Clear();
+		return;
+	}
+
+	_BuildRanks(vertexCells, width);
+
+	std::vector<int32_t> verticesByRank(verticesNumber);
+	for (int vertexId = 0; vertexId < verticesNumber; vertexId++)
+	{
+		verticesByRank[_ranks[vertexId]] = vertexId;
+	}
+
+	std::vector<std::vector<uint32_t>> rows(sources.size());
+
+	// Rows take very different time (sources in small pockets are done at once), so workers take sources one by one.
+	std::atomic<size_t> nextSource(0);
+	const GraphArc* arcs = graph[0].data();
+
+	auto buildRows = [&]()
+	{
+		std::vector<int> distances;
+		std::vector<uint16_t> moves(verticesNumber, 0);
+		RadixHeapQueue q;
+
+		for (size_t i = nextSource++; i < sources.size(); i = nextSource++)
+		{
+			int sourceId = sources[i];
+
+			distances.assign(verticesNumber, INF);
+			distances[sourceId] = 0;
+			q.Reset(verticesNumber, INF);
+			q.Update(0, sourceId);
+
+			while (!q.IsEmpty())
+			{
+				int distance = q.GetTopKey();
+				int currentId = q.Pop();
+
+				if (distances[currentId] < distance)
+				{
+					continue; // Outdated item, vertex was reached cheaper later.
+				}
+
+				for (const GraphArc& arc : graph[currentId])
+				{
+					int direction = arcDirections[&arc - arcs];
+					uint16_t arcMoves = 0;
+					if (_rows == PathDatabaseRows::Trees)
+					{
+						arcMoves = (uint16_t)(1u << (PATH_DATABASE_DIRECTIONS - 1 - direction)); // Back to the current vertex.
+					}
+					else
+					{
+						arcMoves = currentId == sourceId ? (uint16_t)(1u << direction) : moves[currentId];
+					}
+
+					int newDistance = distance + arc.Weight;
+					if (distances[arc.To] > newDistance)
+					{
+						distances[arc.To] = newDistance;
+						moves[arc.To] = arcMoves;
+						q.Update(newDistance, arc.To);
+					}
+					else if (distances[arc.To] == newDistance && arc.Weight > 0)
+					{
+						moves[arc.To] |= arcMoves;
+					}
+				}
+			}
+
+			// The first run always starts at rank 0, so every lookup finds its run.
+			std::vector<uint32_t>& runs = rows[i];
+			uint32_t runStart = 0;
+			uint32_t runMoves = ~0u;
+
+			for (int rank = 0; rank < verticesNumber; rank++)
+			{
+				int vertexId = verticesByRank[rank];
+				if (vertexId == sourceId)
+				{
+					continue;
+				}
+
+				uint32_t optimalMoves = distances[vertexId] < INF ? moves[vertexId] : 1u << PATH_DATABASE_UNREACHABLE;
+				if ((runMoves & optimalMoves) == 0)
+				{
+					runs.push_back((runStart << PATH_DATABASE_MOVE_BITS) | (uint32_t)std::countr_zero(runMoves));
+					runStart = rank;
+					runMoves = optimalMoves;
+				}
+				else
+				{
+					runMoves &= optimalMoves;
+				}
+			}
+
+			// The last run, or the only one if the source is the only vertex.
+			runs.push_back((runStart << PATH_DATABASE_MOVE_BITS) | (uint32_t)std::min(std::countr_zero(runMoves), (int)PATH_DATABASE_UNREACHABLE));
+			runs.shrink_to_fit();
+		}
+	};
+
+	int workersNumber = std::max(1, (int)std::thread::hardware_concurrency());
+	std::vector<std::thread> workers;
+	for (int i = 1; i < workersNumber; i++)
+	{
+		workers.emplace_back(buildRows);
+	}
+
+	buildRows();
+
+	for (auto& worker : workers)
+	{
+		worker.join();
+	}
+
+	size_t runsNumber = 0;
+	for (const auto& runs : rows)
+	{
+		runsNumber += runs.size();
+	}
+
+	_runs.Reserve(runsNumber);
+	_rowOffsets.Reserve(rows.size() + 1);
+	_rowOffsets.PushBack(0);
+	for (auto& runs : rows)
+	{
+		for (uint32_t run : runs)
+		{
+			_runs.PushBack(run);
+		}
+
+		_rowOffsets.PushBack((int64_t)_runs.GetSize());
+		std::vector<uint32_t>().swap(runs);
+	}
+
+	_sources.Reserve(sources.size());
+	for (int32_t sourceId : sources)
+	{
+		_sources.PushBack(sourceId);
+	}
+
+	_IndexSources(verticesNumber);
+}
+
+/// <summary>
+/// Numbers vertices in the order of their cells along the Hilbert curve.
+/// </summary>
+void PathDatabase::_BuildRanks(const FlatArray<int32_t>& vertexCells, int width)
+{
+	int verticesNumber = (int)vertexCells.GetSize();
+
+	int height = 1;
+	for (int vertexId = 0; vertexId < verticesNumber; vertexId++)
+	{
+		height = std::max(height, vertexCells[vertexId] / width + 1);
+	}
+
+	int size = 1;
+	while (size < std::max(width, height))
+	{
+		size *= 2;
+	}
+
+	std::vector<std::pair<uint64_t, int>> indices(verticesNumber);
+	for (int vertexId = 0; vertexId < verticesNumber; vertexId++)
+	{
+		int cell = vertexCells[vertexId];
+		indices[vertexId] = { GetHilbertIndex(size, cell % width, cell / width), vertexId };
+	}
+
+	std::sort(indices.begin(), indices.end());
+
+	_ranks.Assign(verticesNumber, 0);
+	for (int rank = 0; rank < verticesNumber; rank++)
+	{
+		_ranks.Set(indices[rank].second, rank);
+	}
+}
+
+/// <summary>
+/// Lists neighbours of every vertex by direction: vertices its arcs go to for first moves, vertices having arcs into it for trees.
+/// Fills the direction of every arc of the graph: from the cell of its source to the cell of its target.
+/// </summary>
+bool PathDatabase::_BuildNeighbours(const Graph& graph, const FlatArray<int32_t>& vertexCells, int width, std::vector<uint8_t>& arcDirections)
+{
+	int verticesNumber = graph.GetVerticesNumber();
+
+	_neighbours.Assign((size_t)verticesNumber * PATH_DATABASE_DIRECTIONS, -1);
+	arcDirections.resize(graph.GetArcsNumber());
+
+	const GraphArc* arcs = graph[0].data();
+	for (int fromId = 0; fromId < verticesNumber; fromId++)
+	{
+		int fromX = vertexCells[fromId] % width;
+		int fromY = vertexCells[fromId] / width;
+
+		for (const GraphArc& arc : graph[fromId])
+		{
+			int dx = vertexCells[arc.To] % width - fromX;
+			int dy = vertexCells[arc.To] / width - fromY;
+			if (std::abs(dx) > 1 || std::abs(dy) > 1 || (dx == 0 && dy == 0))
+			{
+				return false;
+			}
+
+			int direction = (dy + 1) * 3 + (dx + 1);
+			direction -= direction > 4; // The cell itself has no direction.
+			arcDirections[&arc - arcs] = (uint8_t)direction;
+
+			if (_rows == PathDatabaseRows::FirstMoves)
+			{
+				_neighbours.Set((size_t)fromId * PATH_DATABASE_DIRECTIONS + direction, arc.To);
+			}
+			else
+			{
+				_neighbours.Set((size_t)arc.To * PATH_DATABASE_DIRECTIONS + PATH_DATABASE_DIRECTIONS - 1 - direction, fromId);
+			}
+		}
+	}
+
+	return true;
+}
+
+void PathDatabase::_IndexSources(int verticesNumber)
+{
+	_sourceRows.assign(verticesNumber, -1);
+	for (size_t row = 0; row < _sources.GetSize(); row++)
+	{
+		_sourceRows[_sources[row]] = (int32_t)row;
+	}
+}
+
+/// <summary>
+/// Move of the run covering the vertex in the row: the last run starting at its rank or before it.
+/// </summary>
+uint32_t PathDatabase::_GetMove(int row, int vertexId) const
+{
+	const uint32_t* first = _runs.GetData() + _rowOffsets[row];
+	const uint32_t* last = _runs.GetData() + _rowOffsets[row + 1];
+
+	uint32_t key = ((uint32_t)_ranks[vertexId] << PATH_DATABASE_MOVE_BITS) | PATH_DATABASE_UNREACHABLE;
+	const uint32_t* run = std::upper_bound(first, last, key) - 1;
+
+	return *run & PATH_DATABASE_UNREACHABLE;
+}
+
+/// <summary>
+/// First moves: walks from the start to the finish, one lookup in the row of every cell of the path.
+/// Trees: walks from the finish back to the start, every lookup in the row of the start.
+/// </summary>
+std::vector<int> PathDatabase::FindPath(int startId, int finishId) const
+{
+	if (!HasSource(startId) || finishId < 0 || finishId >= (int)_sourceRows.size())
+	{
+		return {};
+	}
+
+	bool isForward = _rows == PathDatabaseRows::FirstMoves;
+	int row = _sourceRows[startId];
+	int lastId = isForward ? finishId : startId;
+	std::vector<int> path = { isForward ? startId : finishId };
+
+	for (int vertexId = path.back(); vertexId != lastId; vertexId = path.back())
+	{
+		uint32_t move = _GetMove(isForward ? _sourceRows[vertexId] : row, isForward ? finishId : vertexId);
+		if (move == PATH_DATABASE_UNREACHABLE || path.size() > _sourceRows.size())
+		{
+			return {};
+		}
+
+		path.push_back(_neighbours[(size_t)vertexId * PATH_DATABASE_DIRECTIONS + move]);
+	}
+
+	if (!isForward)
+	{
+		std::reverse(path.begin(), path.end());
+	}
+
+	return path;
+}
+
+/// <summary>
+/// Writes the tables into filepath, marked with the terrain hash.
+/// </summary>
+bool PathDatabase::Save(const std::string& filepath, uint64_t terrainHash) const
+{
+	if (!IsBuilt())
+	{
+		return false;
+	}
+
+	PathDatabaseHeader header = {};
+	memcpy(header.Magic, PATH_DATABASE_MAGIC, sizeof(header.Magic));
+	header.Version = PATH_DATABASE_VERSION;
+	header.VerticesNumber = (int32_t)_ranks.GetSize();
+	header.SourcesNumber = (int32_t)_sources.GetSize();
+	header.Rows = (int32_t)_rows;
+	header.RunsNumber = _runs.GetSize();
+	header.TerrainHash = terrainHash;
+
+	std::ofstream output(filepath, std::ios::binary | std::ios::trunc);
+	if (!output)
+	{
+		std::cerr << "Error opening " << filepath << " for writing." << std::endl;
+		return false;
+	}
+
+	output.write((const char*)&header, sizeof(header));
+	output.write((const char*)_rowOffsets.GetData(), _rowOffsets.GetSize() * sizeof(int64_t));
+	output.write((const char*)_ranks.GetData(), _ranks.GetSize() * sizeof(int32_t));
+	output.write((const char*)_neighbours.GetData(), _neighbours.GetSize() * sizeof(int32_t));
+	output.write((const char*)_sources.GetData(), _sources.GetSize() * sizeof(int32_t));
+	output.write((const char*)_runs.GetData(), _runs.GetSize() * sizeof(uint32_t));
+
+	if (!output)
+	{
+		std::cerr << "Error writing " << filepath << "." << std::endl;
+		return false;
+	}
+
+	std::cout << "Path database saved to " << filepath << " (" << GetMemoryUsage() / 1024 << " KB)." << std::endl;
+
+	return true;
+}
+
+/// <summary>
+/// Maps the tables saved for the same terrain, number of vertices and sources (every vertex if empty).
+/// </summary>
+bool PathDatabase::Load(const std::string& filepath, uint64_t terrainHash, int verticesNumber, const std::vector<int>& sourceIds)
+{
+	Clear();
+
+	if (!_file.Open(filepath))
+	{
+		return false;
+	}
+
+	std::vector<int32_t> sources = GetSources(sourceIds, verticesNumber);
+	PathDatabaseRows rows = sourceIds.empty() ? PathDatabaseRows::FirstMoves : PathDatabaseRows::Trees;
+	const PathDatabaseHeader* header = (const PathDatabaseHeader*)_file.GetData();
+
+	if (_file.GetSize() < sizeof(PathDatabaseHeader) ||
+		memcmp(header->Magic, PATH_DATABASE_MAGIC, sizeof(header->Magic)) != 0 ||
+		header->Version != PATH_DATABASE_VERSION ||
+		header->VerticesNumber != verticesNumber ||
+		header->SourcesNumber != (int32_t)sources.size() ||
+		header->Rows != (int32_t)rows ||
+		header->TerrainHash != terrainHash)
+	{
+		std::cout << filepath << " was saved for another version of the map or other sources, path database will be computed again." << std::endl;
+		_file.Close();
+		return false;
+	}
+
+	// Row offsets go first, right after the header, so they stay aligned.
+	const int64_t* rowOffsets = (const int64_t*)(_file.GetData() + sizeof(PathDatabaseHeader));
+	const int32_t* ranks = (const int32_t*)(rowOffsets + sources.size() + 1);
+	const int32_t* neighbours = ranks + verticesNumber;
+	const int32_t* savedSources = neighbours + (size_t)verticesNumber * PATH_DATABASE_DIRECTIONS;
+	const uint32_t* runs = (const uint32_t*)(savedSources + sources.size());
+
+	if (_file.GetSize() != (size_t)((const char*)(runs + header->RunsNumber) - _file.GetData()) ||
+		memcmp(savedSources, sources.data(), sources.size() * sizeof(int32_t)) != 0)
+	{
+		std::cout << filepath << " was saved for another version of the map or other sources, path database will be computed again." << std::endl;
+		_file.Close();
+		return false;
+	}
+
+	_rows = rows;
+	_rowOffsets.Attach(rowOffsets, sources.size() + 1);
+	_ranks.Attach(ranks, verticesNumber);
+	_neighbours.Attach(neighbours, (size_t)verticesNumber * PATH_DATABASE_DIRECTIONS);
+	_sources.Attach(savedSources, sources.size());
+	_runs.Attach(runs, header->RunsNumber);
+
+	_IndexSources(verticesNumber);
+
+	return true;
+}
@@ -0,0 +1,168 @@
+#ifndef PATHDATABASE_H
+#define PATHDATABASE_H
+
+#include "graph.h"
+#include "MappedFile.h"
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Compressed path database file, kept next to the map file: PathDatabaseHeader followed by int64_t[sourcesNumber + 1] row offsets,
+// int32_t[verticesNumber] ranks, int32_t[verticesNumber * PATH_DATABASE_DIRECTIONS] neighbours, int32_t[sourcesNumber] sources
+// and uint32_t[runsNumber] runs (see PathDatabase).
+const char PATH_DATABASE_EXTENSION[] = ".cpd";
+const char PATH_DATABASE_MAGIC[8] = { 'P', 'A', 'T', 'H', 'D', 'B', '\0', '\0' };
+
+// Increase on any change of the layout or of the numbering, old files will be rebuilt.
+const uint32_t PATH_DATABASE_VERSION = 1;
+
+// Run is the rank of its first vertex shifted by these bits and the move of the run in them.
+const int PATH_DATABASE_MOVE_BITS = 4;
+
+// Moves are directions to the neighbouring cells: (dy + 1) * 3 + (dx + 1), the cell itself skipped.
+const int PATH_DATABASE_DIRECTIONS = 8;
+
+// Move of the targets not reachable from the source.
+const uint32_t PATH_DATABASE_UNREACHABLE = (1u << PATH_DATABASE_MOVE_BITS) - 1;
+
+/// <summary>
+/// What rows of the path database store. FirstMoves: first move of the path from the source to every target,
+/// a path is a chain of lookups in the rows of its cells, so every vertex is a source. Trees: move from every target
+/// to its parent in the shortest path tree of the source, the whole path is in the row of its start, so any sources will do,
+/// but rows are much longer: moves towards the source change behind every obstacle, first moves change only where paths part.
+/// </summary>
+enum class PathDatabaseRows
+{
+	FirstMoves,
+	Trees
+};
+
+struct PathDatabaseHeader
+{
+	char Magic[8];
+	uint32_t Version;
+	int32_t VerticesNumber;
+	int32_t SourcesNumber;
+	int32_t Rows;
+	uint64_t RunsNumber;
+	uint64_t TerrainHash; // Terrain::GetHash() of the map the paths were computed for.
+};
+
+/// <summary>
+/// Compressed path database (CPD) for static maps without negative cells: a path is read from the table with no search at all.
+/// Row of the source stores a move (direction to the neighbouring cell) for every target, see PathDatabaseRows.
+/// Targets are numbered along the Hilbert curve over the grid, so neighbouring cells mostly share their moves,
+/// and the row is compressed into runs of the same move: tens of runs per row of first moves instead of a move per vertex.
+/// A lookup is a binary search over the runs of the row, so a path takes one lookup per cell.
+/// The whole table has first moves, the table restricted to some sources (e.g. cells where orders start) has trees.
+/// </summary>
+class PathDatabase
+{
+public:
+	PathDatabase();
+
+	/// <summary>
+	/// Computes first moves of every vertex if sourceIds are empty, otherwise trees of sourceIds, over the graph (Graph or GridGraph).
+	/// Vertex cells (terrain indices) of the map with its width give the positions for the Hilbert numbering.
+	/// Sources are computed in parallel.
+	/// </summary>
+	template <typename TGraph>
+	void Build(const TGraph& graph, const FlatArray<int32_t>& vertexCells, int width, const std::vector<int>& sourceIds)
+	{
+		if constexpr (std::is_same_v<TGraph, Graph>)
+		{
+			_Build(graph, vertexCells, width, sourceIds);
+		}
+		else
+		{
+			// Dijkstra runs over CSR arrays: the implicit grid graph is packed into them first.
+			Graph packed;
+			packed.Reset(graph.GetVerticesNumber());
+			for (int fromId = 0; fromId < graph.GetVerticesNumber(); fromId++)
+			{
+				graph.ForEachArc(fromId, [&](int toId, int weight) { packed.AddArc(fromId, toId, weight); });
+			}
+			packed.Finish();
+
+			_Build(packed, vertexCells, width, sourceIds);
+		}
+	}
+
+	void Clear();
+
+	bool IsBuilt() const { return _sources.GetSize() > 0; }
+
+	/// <summary>
+	/// Paths from the vertex are in the table: it has its row (every vertex has one in the table of first moves).
+	/// </summary>
+	bool HasSource(int vertexId) const { return vertexId >= 0 && vertexId < (int)_sourceRows.size() && _sourceRows[vertexId] >= 0; }
+	int GetSourcesNumber() const { return (int)_sources.GetSize(); }
+	size_t GetRunsNumber() const { return _runs.GetSize(); }
+
+	/// <summary>
+	/// Size of the tables, whether they are owned or mapped from the file.
+	/// </summary>
+	size_t GetMemoryUsage() const;
+
+	/// <summary>
+	/// Writes the tables into filepath, marked with the terrain hash.
+	/// </summary>
+	bool Save(const std::string& filepath, uint64_t terrainHash) const;
+
+	/// <summary>
+	/// Maps the tables saved for the same terrain, number of vertices and sources (every vertex if empty).
+	/// Fails if there is no file or it was saved for something else.
+	/// </summary>
+	bool Load(const std::string& filepath, uint64_t terrainHash, int verticesNumber, const std::vector<int>& sourceIds);
+
+	/// <summary>
+	/// Returns vertex ids of every cell of the shortest path, start and finish included, or empty path
+	/// if the finish is not reachable or the start has no row.
+	/// </summary>
+	std::vector<int> FindPath(int startId, int finishId) const;
+
+private:
+	void _Build(const Graph& graph, const FlatArray<int32_t>& vertexCells, int width, const std::vector<int>& sourceIds);
+
+	/// <summary>
+	/// Numbers vertices in the order of their cells along the Hilbert curve.
+	/// </summary>
+	void _BuildRanks(const FlatArray<int32_t>& vertexCells, int width);
+
+	/// <summary>
+	/// Lists neighbours of every vertex by direction: vertices its arcs go to for first moves, vertices having arcs into it for trees.
+	/// Fills the direction of every arc of the graph: from the cell of its source to the cell of its target.
+	/// Fails if an arc joins cells which are not adjacent.
+	/// </summary>
+	bool _BuildNeighbours(const Graph& graph, const FlatArray<int32_t>& vertexCells, int width, std::vector<uint8_t>& arcDirections);
+
+	/// <summary>
+	/// Maps every vertex to its row, -1 for vertices which are not sources.
+	/// </summary>
+	void _IndexSources(int verticesNumber);
+
+	/// <summary>
+	/// Move of the run covering the vertex in the row.
+	/// </summary>
+	uint32_t _GetMove(int row, int vertexId) const;
+
+private:
+	// Position of every vertex along the Hilbert curve.
+	FlatArray<int32_t> _ranks;
+
+	PathDatabaseRows _rows;
+
+	// Neighbour of vertex v in the direction d: _neighbours[v * PATH_DATABASE_DIRECTIONS + d], -1 if there is none.
+	FlatArray<int32_t> _neighbours;
+
+	// Runs of the row of source _sources[i]: _runs[_rowOffsets[i] .. _rowOffsets[i + 1]), in the order of ranks.
+	FlatArray<int32_t> _sources;
+	FlatArray<int64_t> _rowOffsets;
+	FlatArray<uint32_t> _runs;
+
+	std::vector<int32_t> _sourceRows;
+	MappedFile _file;
+};
+
+#endif
@@ -1,9 +1,12 @@
 #include "rectangularmap.h"
-#include "cell.h"
 #include "order.h"
+#include "mapreader.h"
+#include "compiledmap.h"
+#include "searchworkspace.h"
 #include <stack>
 #include <queue>
-#include <unordered_set>
+#include <deque>
+#include <thread>
 
 RectangularMap::RectangularMap(int width, int height, shared_ptr<Focus> focus, RenderWindow& window)
 	: MapBase(window, width, height),
@@ -24,6 +27,117 @@ int RectangularMap::_VertexIndex(int row, int column)
 	return row * _width + column;
 }
 
+/// <summary>
+/// Runs func on the graph representation selected for the map: implicit grid or adjacency list.
+/// </summary>
+template <typename TFunc>
+auto RectangularMap::_WithGraph(TFunc&& func) const
+{
+	if (_IsImplicitGraphUsed())
+	{
+		return func(_gridGraph);
+	}
+
+	return func(_adjacencyList);
+}
+
+/// <summary>
+/// Same as _WithGraph, but passes reversed graph as well, for bidirectional searches.
+/// Non-weightened graphs are undirected, so the adjacency list is reversed graph of itself.
+/// </summary>
+template <typename TFunc>
+auto RectangularMap::_WithGraphs(TFunc&& func) const
+{
+	if (_IsImplicitGraphUsed())
+	{
+		return func(_gridGraph, ReverseGridGraph(_gridGraph));
+	}
+
+	return func(_adjacencyList, _isWeighten ? _reverseAdjacencyList : _adjacencyList);
+}
+
+/// <summary>
+/// Runs func with an empty queue of the type selected for the map (see MapBase::UseSearchQueue).
+/// </summary>
+template <typename TFunc>
+auto RectangularMap::_WithQueue(TFunc&& func) const
+{
+	switch (_GetSearchQueueType())
+	{
+	case SearchQueueType::BinaryHeap:
+		return func(HeapQueue());
+	case SearchQueueType::IndexedHeap:
+		return func(IndexedHeapQueue());
+	case SearchQueueType::Buckets:
+		return func(BucketQueue());
+	case SearchQueueType::Auto:
+	case SearchQueueType::RadixHeap:
+		break;
+	}
+
+	return func(RadixHeapQueue());
+}
+
+/// <summary>
+/// Runs func with the heuristic selected for the map (see MapBase::UseSearchHeuristic).
+/// </summary>
+template <typename TFunc>
+auto RectangularMap::_WithHeuristic(TFunc&& func) const
+{
+	switch (_searchHeuristicType)
+	{
+	case SearchHeuristicType::Octile:
+		return func(OctileHeuristic());
+	case SearchHeuristicType::Euclidean:
+		return func(EuclideanHeuristic());
+	case SearchHeuristicType::Zero:
+		return func(ZeroHeuristic());
+	case SearchHeuristicType::Landmarks:
+		if (_landmarkTable.IsBuilt())
+		{
+			return func(LandmarkHeuristic());
+		}
+		break;
+	case SearchHeuristicType::Manhattan:
+		break;
+	}
+
+	return func(ManhattanHeuristic());
+}
+
+/// <summary>
+/// Estimate function of THeuristic: lower bound of the distance from a vertex to vertexId if toVertex is set,
+/// otherwise from vertexId to a vertex.
+/// </summary>
+template <typename THeuristic>
+auto RectangularMap::_GetEstimate(int vertexId, bool toVertex) const
+{
+	if constexpr (std::is_same_v<THeuristic, LandmarkHeuristic>)
+	{
+		return [this, vertexId, toVertex](int otherId) {
+			return toVertex ? _landmarkTable.Estimate(otherId, vertexId) : _landmarkTable.Estimate(vertexId, otherId);
+		};
+	}
+	else
+	{
+		// Geometric estimates are symmetric.
+		int vertexX, vertexY;
+		std::tie(vertexX, vertexY) = GetVertexCoordinate(vertexId);
+
+		return [this, vertexX, vertexY](int otherId) {
+			int x, y;
+			std::tie(x, y) = GetVertexCoordinate(otherId);
+			return THeuristic::Estimate(abs(vertexX - x), abs(vertexY - y)) * _minWeight;
+		};
+	}
+}
+
+template <typename THeuristic>
+int RectangularMap::_GetEstimateStep() const
+{
+	return std::is_same_v<THeuristic, LandmarkHeuristic> ? _maxWeight : _minWeight;
+}
+
 /// <summary>
 ///  Creates a fully Graph representation of the map, that:
 ///  1. Avoids non - moveable cells to build the paths more efficiently(than in Grid).
@@ -48,7 +162,27 @@ void RectangularMap::InitialiseGraph()
 		}
 		else
 		{
-			std::cout << "Load simple map with blocks and grass. Will use BFS for finding path." << std::endl;
+			std::cout << "Load simple map with blocks and grass. Will use Jump Point Search for finding path." << std::endl;
+
+			_jumpPointSearch.Build(_terrain, _vertexCells);
+			std::cout << "Jump point search bitboards take " << _jumpPointSearch.GetMemoryUsage() / 1024 << " KB." << std::endl;
+		}
+
+		_InitialiseHierarchicalSearch();
+
+		if (_IsImplicitGraphUsed())
+		{
+			// Neighbours are derived from the terrain during the search, so there is no adjacency list to build.
+			_gridGraph.Build(_terrain, _vertexCells);
+			_adjacencyList.Finish();
+
+			std::cout << "Implicit grid graph takes " << _gridGraph.GetMemoryUsage() / 1024 << " KB for " << _verticesNumber << " vertices." << std::endl;
+
+			_InitialiseComponents();
+			_InitialiseContractionHierarchy();
+			_InitialiseLandmarks();
+			_InitialisePathDatabase();
+			return;
 		}
 
 		// Check connections of the current GRID CELL to other cells above, below, left and right:
@@ -59,41 +193,59 @@ void RectangularMap::InitialiseGraph()
 		vector<int> dr{ -1, +1, 0, 0 };
 		vector<int> dc{ 0, 0, -1, +1 };
 
-		unordered_set<int> visited;
+		// Negative cells that already got their single incoming edge.
+		vector<bool> visited(_verticesNumber, false);
 
-		for (int rr = 0; rr < _grid.size(); rr++)
+		for (int rr = 0; rr < _terrain.GetHeight(); rr++)
 		{
-			for (int cc = 0; cc < _grid[rr].size(); cc++)
+			for (int cc = 0; cc < _terrain.GetWidth(); cc++)
 			{
-				if (_grid[rr][cc]->GetId() > -1)
+				int fromId = _terrain.GetVertexId(_terrain.Index(rr, cc));
+
+				if (fromId > -1)
 				{
 					for (int i = 0; i < 4; i++)
 					{
 						int r = rr + dr[i];
 						int c = cc + dc[i];
 
-						if (r >= 0 && c >= 0 && r < _width && c < _height &&
-							_grid[r][c]->GetId() > -1)
+						if (r >= 0 && c >= 0 && r < _terrain.GetHeight() && c < _terrain.GetWidth())
 						{
+							int toCell = _terrain.Index(r, c);
+							int toId = _terrain.GetVertexId(toCell);
+
+							if (toId < 0)
+							{
+								continue;
+							}
+
 							if (_isNegativeWeighten)
 							{
 								// Implement a little trick. Since every edge of the GRID is dually-connected,
 								// we never get DAG - instead, it will be always cyclic. This will make it impossible to
 								// run any Path finding algorithm on it, since it will contain negative cycles.
 								// So, what we do here, is making specifically negative cells Single-Directed by removing second edge.
+								// Negative cells get a single arc in and no arcs out, so any cycle goes through non-negative cells only,
+								// while non-negative cells stay connected both ways as on any other map.
 
-								if (_grid[r][c]->GetWeight() < 0 && visited.count(_grid[r][c]->GetId()) == 0)
+								if (_terrain.GetCost(_terrain.Index(rr, cc)) < 0)
 								{
-									_adjacencyList[_grid[rr][cc]->GetId()].push_back(_grid[r][c]);
-									visited.insert(_grid[r][c]->GetId());
+									continue;
 								}
 
-								//_edgesList.push_back(
-								//	std::make_shared<Edge>(_grid[rr][cc]->GetId(), _grid[r][c]->GetId(), _grid[r][c]->GetWeight()));
+								if (_terrain.GetCost(toCell) >= 0)
+								{
+									_adjacencyList.AddArc(fromId, toId, _terrain.GetCost(toCell));
+								}
+								else if (!visited[toId])
+								{
+									_adjacencyList.AddArc(fromId, toId, _terrain.GetCost(toCell));
+									visited[toId] = true;
+								}
 							}
 							else
 							{
-								_adjacencyList[_grid[rr][cc]->GetId()].push_back(_grid[r][c]);
+								_adjacencyList.AddArc(fromId, toId, _terrain.GetCost(toCell));
 							}
 						}
 					}
@@ -101,6 +253,31 @@ void RectangularMap::InitialiseGraph()
 			}
 		}
 	}
+
+	_adjacencyList.Finish();
+
+	if (_mapLoaded && _isNegativeWeighten)
+	{
+		// Bellman-Ford may stream all arcs in every pass instead of walking the adjacency list.
+		_edgesList.Build(_adjacencyList);
+		std::cout << "Edge list takes " << _edgesList.GetMemoryUsage() / 1024 << " KB for " << _edgesList.GetEdgesNumber() << " edges." << std::endl;
+	}
+
+	if (_mapLoaded && _isWeighten && !_isNegativeWeighten)
+	{
+		// Backward half of bidirectional searches walks arcs in the opposite direction.
+		_adjacencyList.Transpose(_reverseAdjacencyList);
+	}
+
+	if (_mapLoaded)
+	{
+		std::cout << "Graph takes " << _adjacencyList.GetMemoryUsage() / 1024 << " KB for " << _adjacencyList.GetArcsNumber() << " arcs." << std::endl;
+
+		_InitialiseComponents();
+		_InitialiseContractionHierarchy();
+		_InitialiseLandmarks();
+		_InitialisePathDatabase();
+	}
 }
 
 void RectangularMap::Draw() const
@@ -151,88 +328,232 @@ bool RectangularMap::LoadMap(const std::string& filepath, bool shadow)
 		return _mapLoaded;
 	}
 
-	ifstream readstream;
-	readstream.open(filepath);
+	_mapFilepath = filepath;
+
+	if (IsCompiledMapFile(filepath))
+	{
+		if (_LoadCompiledMap(filepath))
+		{
+			_Scale(_terrain.GetWidth(), _terrain.GetHeight());
+			_shadow = shadow;
+			_mapLoaded = true;
+
+			// Terrain and adjacency list are used right from the file, only the implicit grid needs its masks.
+			if (_IsImplicitGraphUsed())
+			{
+				_gridGraph.Build(_terrain, _vertexCells);
+			}
+			else if (_isWeighten && !_isNegativeWeighten)
+			{
+				_adjacencyList.Transpose(_reverseAdjacencyList);
+			}
+			else if (_isNegativeWeighten)
+			{
+				_edgesList.Build(_adjacencyList);
+			}
 
-	Color freeColor = Color::Green;
-	freeColor.r = 34;
-	freeColor.g = 177;
-	freeColor.b = 76;
+			if (!_isWeighten)
+			{
+				_jumpPointSearch.Build(_terrain, _vertexCells);
+				_InitialiseJumpDistances(filepath);
+			}
+
+			_InitialiseHierarchicalSearch();
+			_InitialiseComponents();
+			_InitialiseContractionHierarchy();
+			_InitialiseLandmarks();
+			_InitialisePathDatabase();
 
-	Color blockColor = Color::Black; 
-	Color feeColor = Color::Magenta;
-	feeColor.r = 168;
-	feeColor.g = 168;
-	feeColor.b = 168;
+			std::cout << "Compiled map opened: " << _verticesNumber << " vertices, " << _adjacencyList.GetArcsNumber() << " arcs." << std::endl;
+		}
 
-	Color negativeFeeColor = Color::Cyan;
+		return _mapLoaded;
+	}
 
-	if (readstream)
+	if (_mapFile.Open(filepath))
 	{
+		MapReader reader(std::string_view(_mapFile.GetData(), _mapFile.GetSize()));
+
 		int mapSize = 0;
 		int maxTips = 0;
 		int roverCost = 0;
-		readstream >> mapSize >> maxTips >> roverCost;
+		if (!reader.ReadInt(mapSize) || !reader.ReadInt(maxTips) || !reader.ReadInt(roverCost))
+		{
+			return _mapLoaded;
+		}
 
 		_Scale(mapSize, mapSize);
+		_shadow = shadow;
+		_maxTips = maxTips;
+		_roverCost = roverCost;
 
-		// Fill the grid.
-		_verticesNumber = 0;
+		// Find row boundaries first. Rows are views into the mapped file, symbols go straight into the terrain.
+		std::vector<std::string_view> rows(_height);
 		for (int row = 0; row < _height; row++)
 		{
-			string line;
-			readstream >> line; // std::getline(std::cin, line); 
-			_grid.emplace_back(vector<std::shared_ptr<Cell>>(mapSize));
-
-			if (line.size() != _height)
+			if (!reader.ReadRow(rows[row]) || rows[row].size() != (size_t)_width)
 			{
 				return _mapLoaded;
 			}
+		}
 
-			for (int col = 0; col < _width; col++)
+		// Fill the grid.
+		_FillTerrain(rows);
+		_maxWeight = _GetMaxWeight();
+		_minWeight = _GetMinWeight();
+
+		std::cout << "Terrain takes " << _terrain.GetMemoryUsage() / 1024 << " KB for " << _terrain.GetSize() << " cells." << std::endl;
+
+		// Orders follow the grid: Navigator takes them from the same mapping, so the file is read only once.
+		_orders = reader.GetRest();
+
+		_mapLoaded = true;
+
+		// Make a graph
+ 		InitialiseGraph();
+
+		if (!_isWeighten)
+		{
+			_InitialiseJumpDistances(filepath);
+		}
+	}
+
+	return _mapLoaded;
+}
+
+/// <summary>
+/// Loads JPS+ jump distances saved next to the map file, or computes and saves them if there are none for this terrain.
+/// Maps stay the same for a long time, so the preprocessing is paid once per map version.
+/// </summary>
+void RectangularMap::_InitialiseJumpDistances(const std::string& mapFilepath)
+{
+	std::string filepath = mapFilepath + JUMP_DISTANCES_EXTENSION;
+	uint64_t terrainHash = _terrain.GetHash();
+
+	if (_jumpPointSearch.LoadJumpDistances(filepath, terrainHash))
+	{
+		std::cout << "Jump distances loaded from " << filepath << "." << std::endl;
+		return;
+	}
+
+	_jumpPointSearch.BuildJumpDistances();
+	_jumpPointSearch.SaveJumpDistances(filepath, terrainHash);
+}
+
+/// <summary>
+/// Classifies symbols of the rows into the terrain and numbers moveable cells in row-major order.
+/// Large maps are split into row ranges processed by worker threads; vertex ids are assigned
+/// with a prefix sum over the per-range moveable cells counts, so numbering is the same as in a single thread.
+/// </summary>
+void RectangularMap::_FillTerrain(const std::vector<std::string_view>& rows)
+{
+	struct RowsRange
+	{
+		int Begin;
+		int End;
+		int FirstVertexId;
+		int VerticesNumber;
+		bool IsWeighten;
+		bool IsNegativeWeighten;
+	};
+
+	int rangesNumber = 1;
+	if ((size_t)_width * (size_t)_height >= PARALLEL_PARSING_MIN_CELLS)
+	{
+		rangesNumber = std::clamp((int)std::thread::hardware_concurrency(), 1, _height);
+	}
+
+	std::vector<RowsRange> ranges(rangesNumber);
+	for (int i = 0; i < rangesNumber; i++)
+	{
+		ranges[i] = { (int)((long long)_height * i / rangesNumber), (int)((long long)_height * (i + 1) / rangesNumber), 0, 0, false, false };
+	}
+
+	auto forEachRange = [&](auto&& func)
+	{
+		if (rangesNumber == 1)
+		{
+			func(ranges[0]);
+			return;
+		}
+
+		std::vector<std::thread> workers;
+		workers.reserve(rangesNumber);
+		for (auto& range : ranges)
+		{
+			workers.emplace_back([&func, &range]() { func(range); });
+		}
+
+		for (auto& worker : workers)
+		{
+			worker.join();
+		}
+	};
+
+	// 1. Count moveable cells and find out what kind of map it is.
+	forEachRange([&](RowsRange& range)
+	{
+		for (int row = range.Begin; row < range.End; row++)
+		{
+			for (char symbol : rows[row])
 			{
-				int x = col;
-				int y = row;
-				if (line[col] == BLOCK_CELL)
-				{
-					_grid[row][col] = std::make_shared<Cell>(x, y, line[col], blockColor, shadow, _scaleFactor);
-					_grid[row][col]->SetId(-1);
-				}
-				else
+				if (symbol != BLOCK_CELL)
 				{
-					Color color;
-					if (line[col] == FREE_CELL)
-					{
-						color = freeColor;
-					}
-					else if (line[col] == GRASS_CELL)
+					++range.VerticesNumber;
+
+					if (symbol == GRASS_CELL)
 					{
-						color = feeColor;
-						_isWeighten = true; // Is map data more complicated than simple grid?
+						range.IsWeighten = true; // Is map data more complicated than simple grid?
 					}
-					else if (line[col] == WATER_CELL)
+					else if (symbol == WATER_CELL)
 					{
-						color = negativeFeeColor;
-						_isWeighten = true; // Is map data more complicated than simple grid?
-						_isNegativeWeighten = true;
+						range.IsWeighten = true; // Is map data more complicated than simple grid?
+						range.IsNegativeWeighten = true;
 					}
-
-					_grid[row][col] = std::make_shared<Cell>(x, y, line[col], color, shadow, _scaleFactor);
-					_grid[row][col]->SetId(_verticesNumber);
-					_moveableCells.push_back(_grid[row][col]);
-					++_verticesNumber;
 				}
 			}
 		}
+	});
 
-		_mapLoaded = true;
+	// 2. Prefix sum gives the first vertex id of every range.
+	_verticesNumber = 0;
+	for (auto& range : ranges)
+	{
+		range.FirstVertexId = _verticesNumber;
+		_verticesNumber += range.VerticesNumber;
 
-		// Make a graph
- 		InitialiseGraph();
+		_isWeighten = _isWeighten || range.IsWeighten;
+		_isNegativeWeighten = _isNegativeWeighten || range.IsNegativeWeighten;
 	}
-	readstream.close();
 
-	return _mapLoaded;
+	_terrain.Reset(_width, _height);
+	_vertexCells.Assign(_verticesNumber, 0);
+
+	// 3. Fill the terrain, every range writes only its own cells and vertex ids.
+	forEachRange([&](RowsRange& range)
+	{
+		int vertexId = range.FirstVertexId;
+
+		for (int row = range.Begin; row < range.End; row++)
+		{
+			for (int col = 0; col < _width; col++)
+			{
+				char symbol = rows[row][col];
+				int index = _terrain.Index(row, col);
+
+				if (symbol == BLOCK_CELL)
+				{
+					_terrain.SetCell(index, symbol, -1, _GetWeight(symbol));
+				}
+				else
+				{
+					_terrain.SetCell(index, symbol, vertexId, _GetWeight(symbol));
+					_vertexCells.Set(vertexId, index);
+					++vertexId;
+				}
+			}
+		}
+	});
 }
 
 bool RectangularMap::IsReady()
@@ -245,33 +566,85 @@ std::tuple<float, float, float, float> RectangularMap::GetCoordinateBounds() con
 	return std::make_tuple(0 * _scaleFactor, 0 * _scaleFactor, _width * _scaleFactor, _height * _scaleFactor);
 }
 
-std::vector<std::shared_ptr<Cell>> RectangularMap::GetPath(int x1, int y1, int x2, int y2) const
+std::vector<Coordinate> RectangularMap::GetPath(int x1, int y1, int x2, int y2) const
 {
-	if (_isWeighten)
+	// Cells of different components have no path between them: no search has to walk the whole component to find it out.
+	if (!IsReachable(x1, y1, x2, y2))
 	{
-		if (_isNegativeWeighten)
-		{
-			bool hasNegativeCycle = false;
-			std::vector<std::shared_ptr<Cell>> path;
+		return {};
+	}
 
-			std::tie(hasNegativeCycle, path) = _GetPathByBellmanFord(x1, y1, x2, y2);
+	if (_isWeighten && _isNegativeWeighten)
+	{
+		bool hasNegativeCycle = false;
+		std::vector<int> path;
 
-			if (hasNegativeCycle)
-				return {};
-			else
-				return path;
-		}
+		std::tie(hasNegativeCycle, path) = _useEdgeList && _edgesList.IsBuilt() ?
+			_GetPathByBellmanFordEdgesList(x1, y1, x2, y2) : _GetPathByBellmanFord(x1, y1, x2, y2);
+
+		if (hasNegativeCycle)
+			return {};
 		else
+			return _ToCoordinates(path);
+	}
+
+	// Paths from the sources of the path database are read from it, with no search.
+	if (_pathDatabase.IsBuilt() && (_searchAlgorithm == SearchAlgorithm::Auto || _searchAlgorithm == SearchAlgorithm::PathDatabase))
+	{
+		int startId = GetVertexId(x1, y1);
+		if (_pathDatabase.HasSource(startId))
 		{
-			//return _GetPathByDijkstra(x1, y1, x2, y2);
-			return _GetPathByAStar(x1, y1, x2, y2);
+			return _ToCoordinates(_pathDatabase.FindPath(startId, GetVertexId(x2, y2)));
 		}
 	}
-	else
+
+	switch (_GetSearchAlgorithm())
 	{
-		//return _GetPathByBFSOnGrid(x1, y1, x2, y2);
-		return _GetPathByBFSOnGraph(x1, y1, x2, y2);
+	case SearchAlgorithm::JumpPointSearch:
+		return _ToCoordinates(_jumpPointSearch.FindPath(x1, y1, x2, y2, SearchWorkspace::ForCurrentThread()));
+
+	case SearchAlgorithm::BidirectionalBFS:
+		return _ToCoordinates(_WithGraph([&](const auto& graph) {
+			return _GetPathByBidirectionalBFS(graph, x1, y1, x2, y2);
+		}));
+
+	case SearchAlgorithm::Hierarchical:
+		return _ToCoordinates(_hierarchicalSearch.FindPath(x1, y1, x2, y2, SearchWorkspace::ForCurrentThread()));
+
+	case SearchAlgorithm::ContractionHierarchy:
+		return _ToCoordinates(_contractionHierarchy.FindPath(GetVertexId(x1, y1), GetVertexId(x2, y2), SearchWorkspace::ForCurrentThread()));
+
+	case SearchAlgorithm::AStar:
+		return _ToCoordinates(_WithQueue([&](auto queue) {
+			using TQueue = decltype(queue);
+
+			return _WithHeuristic([&](auto heuristic) {
+				using THeuristic = decltype(heuristic);
+
+				return _WithGraph([&](const auto& graph) {
+					return _GetPathByAStar<TQueue, THeuristic>(graph, x1, y1, x2, y2);
+				});
+			});
+		}));
+
+	case SearchAlgorithm::Auto:
+	case SearchAlgorithm::BidirectionalAStar:
+	case SearchAlgorithm::PathDatabase:
+		// _GetSearchAlgorithm resolves Auto and PathDatabase, bidirectional A* follows the switch.
+		break;
 	}
+
+	return _ToCoordinates(_WithQueue([&](auto queue) {
+		using TQueue = decltype(queue);
+
+		return _WithHeuristic([&](auto heuristic) {
+			using THeuristic = decltype(heuristic);
+
+			return _WithGraphs([&](const auto& graph, const auto& reverseGraph) {
+				return _GetPathByBidirectionalSearch<TQueue, THeuristic>(graph, reverseGraph, x1, y1, x2, y2);
+			});
+		});
+	}));
 }
 
 /// <summary>
@@ -290,389 +663,543 @@ int RectangularMap::_GetWeight(const char symbol) const
 	case WATER_CELL: // Imitate negative-weight cells.
 		return -5;   // -1 is already allocated.
 	}
+
+	return 1;
 }
 
 /// <summary>
-/// Single source shortest path algorithm for weighten graphs that cannot deal with negative weights.
-/// O((E+V)log(V))
+/// Single source shortest path algorithm for weighten graphs with additional heuristic to speed up search.
+/// Estimate of THeuristic is a lower bound of the distance to the finish (see _GetEstimate).
 /// </summary>
-std::vector<std::shared_ptr<Cell>> RectangularMap::_GetPathByDijkstra(int x1, int y1, int x2, int y2) const
+template <typename TQueue, typename THeuristic, typename TGraph>
+std::vector<int> RectangularMap::_GetPathByAStar(const TGraph& graph, int x1, int y1, int x2, int y2) const
 {
- 	int n = _adjacencyList.size();
-	vector<int> shortestPath(n, INF); // Shortest distance from Start to i
-	vector<int> previousVertex(n, -1); // Previous node in shortest path to i.
+	// Shortest distance from Start to i and previous node in shortest path to i.
+	SearchWorkspace& workspace = SearchWorkspace::ForCurrentThread();
+	workspace.Begin(graph.GetVerticesNumber());
+	SearchStatistics& statistics = workspace.GetSearchStatistics();
+
+	int startId = GetVertexId(x1, y1);
+	int finishId = GetVertexId(x2, y2);
+
+	// Lower bound of the distance from the vertex to the finish.
+	auto calcEuristic = _GetEstimate<THeuristic>(finishId, true);
 
-	shared_ptr<Cell> startCell = GetCellFromGrid(y1, x1);
-	int startId = startCell->GetId();
-	shortestPath[startId] = 0;
+	workspace.Visit(startId, 0, -1);
 
-	priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> q;
-	q.push({ 0, startId });
+	// Expanded vertices.
+	VisitedSet& closed = workspace.GetVisited(0);
 
-	while (!q.empty())
+	// Step changes the distance by the arc weight and the estimate by one estimate step at most.
+	TQueue& q = GetQueueForCurrentThread<TQueue>();
+	q.Reset(graph.GetVerticesNumber(), _maxWeight + _GetEstimateStep<THeuristic>(), _tieBreaking != SearchTieBreaking::None);
+	q.Update(calcEuristic(startId), startId, _GetTieKey(0, 0));
+
+	int generated = 1;
+
+	while (!q.IsEmpty())
 	{
-		pair<int, int> c = q.top();
-		q.pop();
+		int priority = q.GetTopKey();
+		int currentId = q.Pop();
+
+		if (_useClosedSet)
+		{
+			// The first item of a vertex has its smallest key, the rest are outdated.
+			if (closed.Test(currentId))
+			{
+				continue;
+			}
+		}
+		else
+		{
+			if (priority > workspace.GetDistance(currentId) + calcEuristic(currentId))
+			{
+				continue; // Outdated item, vertex was reached cheaper later.
+			}
 
-		int distance = c.first;
-		int currentId = c.second;
+			if (closed.Test(currentId))
+			{
+				statistics.Reexpanded++;
+			}
+		}
 
-		if (shortestPath[currentId] < distance) // Защитное условие, т.к. из очереди ничего не удаляется
+		if (currentId == finishId)
 		{
-			continue;
+			// FOUND
+			break;
 		}
 
-		for (size_t i = 0; i < _adjacencyList[currentId].size(); ++i)
+		statistics.Expanded++;
+		closed.Set(currentId);
+
+		graph.ForEachArc(currentId, [&](int toIndex, int weight)
 		{
-			shared_ptr<Cell> toCell = _adjacencyList[currentId][i];
-			int toIndex = toCell->GetId();
-			int weight_vu = _GetWeight(toCell->GetSymbol());
+			if (_useClosedSet && closed.Test(toIndex))
+			{
+				return;
+			}
 
-			int new_distance = distance + weight_vu;
-			if (shortestPath[toIndex] > new_distance)
+			int newDistance = workspace.GetDistance(currentId) + weight;
+			if (workspace.GetDistance(toIndex) > newDistance)
 			{
-				shortestPath[toIndex] = new_distance;
-				previousVertex[toIndex] = currentId;
-				q.push({ new_distance, toIndex });
+				workspace.Visit(toIndex, newDistance, currentId);
+				q.Update(newDistance + calcEuristic(toIndex), toIndex, _GetTieKey(newDistance, generated));
+				generated++;
 			}
-		}
+		});
 	}
 
-	std::vector<int> resultInd = _RetrievePathCellIds(_grid[y2][x2]->GetId(), previousVertex);
+	statistics.Generated += generated;
 
-	// Convert to list of Cells.
-	std::vector<std::shared_ptr<Cell>> result;
-	for (auto& v : resultInd)
-	{
-		if (v >= 0 && v < _moveableCells.size())
-			result.push_back(_moveableCells[v]);
-		else
-			return {};
-	}
+	workspace.GetQueueStatistics() += q.GetStatistics();
 
-	return result;
+	return _RetrievePathCellIds(finishId, workspace);
 }
 
-std::vector<std::shared_ptr<Cell>> RectangularMap::_GetPathByAStar(int x1, int y1, int x2, int y2) const
+/// <summary>
+/// Bidirectional A* for weighten graphs without negative weights (bidirectional Dijkstra with ZeroHeuristic).
+/// Forward search runs on graph from the start, backward search runs on reverseGraph
+/// from the finish, every step advances the side with the smaller queue.
+/// A* uses average potential p(v) = (h_finish(v) - h_start(v)) / 2, which is consistent for both sides at once:
+/// forward keys are d(v) + p(v), backward keys are d(v) - p(v), and searches stop when
+/// topForward + topBackward >= the shortest path found so far. Keys are doubled to stay integer.
+/// </summary>
+template <typename TQueue, typename THeuristic, typename TGraph, typename TReverseGraph>
+std::vector<int> RectangularMap::_GetPathByBidirectionalSearch(const TGraph& graph, const TReverseGraph& reverseGraph,
+	int x1, int y1, int x2, int y2) const
 {
-	// Euclidian distance from node start to specified node id.
-	auto calcEuristic = [](int x, int y, int x2, int y2) {
-		return sqrt(
-			pow(abs(
-				x2 > x ?
-				x2 - x :
-				x - x2), 2) +
-			pow(abs(
-				y2 > y ?
-				y2 - y :
-				y - y2), 2));
+	int startId = GetVertexId(x1, y1);
+	int finishId = GetVertexId(x2, y2);
+
+	if (startId == finishId)
+	{
+		return { startId };
+	}
+
+	// Estimates in steps multiplied by the cheapest step cost are consistent on the 4-connected grid, landmark ones on any graph.
+	auto calcToFinish = _GetEstimate<THeuristic>(finishId, true);
+	auto calcFromStart = _GetEstimate<THeuristic>(startId, false);
+	auto calcPotential = [&](int vertexId)
+	{
+		return calcToFinish(vertexId) - calcFromStart(vertexId);
 	};
 
-	int n = _adjacencyList.size();
-	vector<int> shortestPath(n, INF); // Shortest distance from Start to i
-	vector<int> previousVertex(n, -1); // Previous node in shortest path to i.
+	// Side 0 is forward search from the start, side 1 is backward search from the finish.
+	SearchWorkspace& workspace = SearchWorkspace::ForCurrentThread();
+	workspace.Begin(graph.GetVerticesNumber(), 2);
 
-	int startId = _grid[y1][x1]->GetId();
-	int finishId = _grid[y2][x2]->GetId();
+	// Doubled keys grow by doubled arc weight and change of the potential (two estimate steps at most) per step.
+	TQueue* queues[2] = { &GetQueueForCurrentThread<TQueue>(0), &GetQueueForCurrentThread<TQueue>(1) };
+	for (TQueue* queue : queues)
+	{
+		queue->Reset(graph.GetVerticesNumber(), 2 * (_maxWeight + _GetEstimateStep<THeuristic>()), _tieBreaking != SearchTieBreaking::None);
+	}
+	SearchStatistics& statistics = workspace.GetSearchStatistics();
+
+	// Expanded vertices of each side.
+	VisitedSet* closed[2] = { &workspace.GetVisited(0), &workspace.GetVisited(1) };
 
-	shortestPath[startId] = 0;
+	workspace.Visit(startId, 0, -1, 0);
+	workspace.Visit(finishId, 0, -1, 1);
+	queues[0]->Update(calcPotential(startId), startId, _GetTieKey(0, 0));
+	queues[1]->Update(-calcPotential(finishId), finishId, _GetTieKey(0, 0));
 
-	priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> q;
-	q.push({0, startId });
+	int generated[2] = { 1, 1 };
+	int bestDistance = INF; // Shortest path found so far.
+	int meetingId = -1;
 
-	while (!q.empty())
+	auto relax = [&](int side, int currentId, int toId, int weight)
 	{
-		pair<int, int> cur = q.top();
-		q.pop();
+		if (_useClosedSet && closed[side]->Test(toId))
+		{
+			return;
+		}
 
-		int currentId = cur.second;
+		int newDistance = workspace.GetDistance(currentId, side) + weight;
+		if (workspace.GetDistance(toId, side) > newDistance)
+		{
+			workspace.Visit(toId, newDistance, currentId, side);
+			queues[side]->Update(2 * newDistance + (side == 0 ? calcPotential(toId) : -calcPotential(toId)), toId,
+				_GetTieKey(newDistance, generated[side]));
+			generated[side]++;
 
-		if (currentId == finishId)
+			if (workspace.IsVisited(toId, 1 - side) && newDistance + workspace.GetDistance(toId, 1 - side) < bestDistance)
+			{
+				bestDistance = newDistance + workspace.GetDistance(toId, 1 - side);
+				meetingId = toId;
+			}
+		}
+	};
+
+	while (!queues[0]->IsEmpty() && !queues[1]->IsEmpty())
+	{
+		if (queues[0]->GetTopKey() + queues[1]->GetTopKey() >= 2 * bestDistance)
 		{
-			// FOUND
 			break;
 		}
 
-		for (size_t i = 0; i < _adjacencyList[currentId].size(); ++i)
+		int side = queues[0]->GetSize() <= queues[1]->GetSize() ? 0 : 1;
+
+		int key = queues[side]->GetTopKey();
+		int currentId = queues[side]->Pop();
+
+		if (_useClosedSet)
 		{
-			shared_ptr<Cell> toCell = _adjacencyList[currentId][i];
-			int toIndex = toCell->GetId();
-			int weight = _GetWeight(toCell->GetSymbol());
+			// The first item of a vertex has its smallest key, the rest are outdated.
+			if (closed[side]->Test(currentId))
+			{
+				continue;
+			}
+		}
+		else
+		{
+			int potential = side == 0 ? calcPotential(currentId) : -calcPotential(currentId);
+			if (key != 2 * workspace.GetDistance(currentId, side) + potential)
+			{
+				continue; // Outdated item, vertex was reached cheaper later.
+			}
 
-			int newDistance = shortestPath[currentId] + weight;
-			if (shortestPath[toIndex] > newDistance)
+			if (closed[side]->Test(currentId))
 			{
-				shortestPath[toIndex] = newDistance;
-				previousVertex[toIndex] = currentId;
-				int priority = newDistance + calcEuristic(_moveableCells[toIndex]->GetX(), _moveableCells[toIndex]->GetY(), x2, y2);
-				q.push({ priority, toIndex });
+				statistics.Reexpanded++;
 			}
 		}
+
+		statistics.Expanded++;
+		closed[side]->Set(currentId);
+
+		if (side == 0)
+		{
+			graph.ForEachArc(currentId, [&](int toId, int weight) { relax(0, currentId, toId, weight); });
+		}
+		else
+		{
+			reverseGraph.ForEachArc(currentId, [&](int toId, int weight) { relax(1, currentId, toId, weight); });
+		}
 	}
 
-	std::vector<int> resultInd = _RetrievePathCellIds(finishId, previousVertex);
+	statistics.Generated += generated[0] + generated[1];
+	workspace.GetQueueStatistics() += queues[0]->GetStatistics();
+	workspace.GetQueueStatistics() += queues[1]->GetStatistics();
 
-	// Convert to list of Cells.
-	std::vector<std::shared_ptr<Cell>> result;
-	for (auto& v : resultInd)
+	if (meetingId == -1)
 	{
-		if (v >= 0 && v < _moveableCells.size())
-			result.push_back(_moveableCells[v]);
-		else
-			return {};
+		return {};
 	}
 
-	return result;
+	// Start .. meeting vertex comes from the forward tree, the rest up to the finish from the backward one.
+	std::vector<int> path;
+	for (int v = meetingId; v != -1; v = workspace.GetPrevious(v, 0))
+	{
+		path.push_back(v);
+	}
+	std::reverse(path.begin(), path.end());
+
+	for (int v = workspace.GetPrevious(meetingId, 1); v != -1; v = workspace.GetPrevious(v, 1))
+	{
+		path.push_back(v);
+	}
+
+	return path;
 }
 
-std::tuple<bool, std::vector<std::shared_ptr<Cell>>> RectangularMap::_GetPathByBellmanFord(int x1, int y1, int x2, int y2) const
+/// <summary>
+/// Queue-based Bellman-Ford (SPFA) for weighten graphs with negative weights: only vertices whose distance has decreased
+/// are scanned again, so it takes a few scans per vertex on grids instead of V - 1 passes over all arcs.
+/// Queue is ordered by SLF (a vertex closer than the head of the queue goes to its front) and LLL (a head farther than
+/// the average distance of the queue goes to its back). Negative cycles are caught by Tarjan's subtree disassembly:
+/// when the distance of a vertex decreases, its subtree in the shortest path tree is taken apart (the distances there
+/// are too large now, so the vertices leave the queue), and if the vertex scanned is in that subtree, the arc closes a negative cycle.
+/// </summary>
+std::tuple<bool, std::vector<int>> RectangularMap::_GetPathByBellmanFord(int x1, int y1, int x2, int y2) const
 {
-	int verticesNumber = _adjacencyList.size();
-	vector<int> shortestPath(verticesNumber, INF); // Shortest distance from Start to i
-	vector<int> previousVertex(verticesNumber, -1); // Previous node in shortest path to i.
-
-	shared_ptr<Cell> startCell = GetCellFromGrid(y1, x1);
-	int startId = startCell->GetId();
-	shortestPath[startId] = 0;
-
-	bool updated = false;
-	// For each vertex, apply relaxation for all the edges V - 1 times.
-	// It's important that we should be able to find optimal solution for not more than V - 1 relaxation steps.
-	for (int v = 0; v < verticesNumber - 1; v++)
+	int verticesNumber = _adjacencyList.GetVerticesNumber();
+
+	// Shortest distance from Start to i and previous node in shortest path to i.
+	SearchWorkspace& workspace = SearchWorkspace::ForCurrentThread();
+	workspace.Begin(verticesNumber);
+	SearchStatistics& statistics = workspace.GetSearchStatistics();
+
+	int startId = GetVertexId(x1, y1);
+	int finishId = GetVertexId(x2, y2);
+	workspace.Visit(startId, 0, -1);
+
+	// Shortest path tree as the list of its vertices in preorder: subtree of a vertex is the run of vertices following it
+	// with greater depth. Depth -1 marks vertices which are not in the tree. Negative arcs allow no early exit,
+	// so the search reaches every vertex reachable from the start anyway, and the arrays are simply allocated for it.
+	std::vector<int> treeNext(verticesNumber, -1);
+	std::vector<int> treePrevious(verticesNumber, -1);
+	std::vector<int> depths(verticesNumber, -1);
+	depths[startId] = 0;
+
+	// Disassembled vertices stay in the deque until they are popped, so the flag tells whether the vertex is queued.
+	std::vector<bool> queued(verticesNumber, false);
+	std::deque<int> q;
+	int64_t queuedDistances = 0;
+	int64_t queuedNumber = 1;
+
+	q.push_back(startId);
+	queued[startId] = true;
+	statistics.Generated++;
+
+	bool hasNegativeCycle = false;
+	while (!q.empty() && !hasNegativeCycle)
 	{
-		updated = false;
-		for (size_t fromId = 0; fromId < _adjacencyList.size(); ++fromId)
+		int currentId = q.front();
+		q.pop_front();
+
+		if (!queued[currentId])
 		{
-			for (size_t to = 0; to < _adjacencyList[fromId].size(); ++to)
-			{
-				shared_ptr<Cell> toCell = _adjacencyList[fromId][to];
-				int toId = toCell->GetId();
-				int weight_vu = _GetWeight(toCell->GetSymbol());
+			continue;
+		}
 
-				int new_distance = shortestPath[fromId] + weight_vu;
-				if (shortestPath[toId] > new_distance)
-				{
-					shortestPath[toId] = new_distance;
-					previousVertex[toId] = fromId;
-					updated = true;
-				}
-			}
+		int distance = workspace.GetDistance(currentId);
+		if (distance * queuedNumber > queuedDistances && !q.empty())
+		{
+			q.push_back(currentId);
+			continue;
 		}
-		// Only in the worst case does it take V-1 iterations for the Bellman-Ford
-		// algorithm to complete. Another stopping condition is when we're unable to
-		// relax an edge, this means we have reached the optimal solution early.
-		if (!updated)
-			break;
-	}
 
-	// Run one more relaxation step to detect which nodes are part of a negative cycle. 
-	bool hasNegativeCycle = false;
-	for (int k = 0; k < verticesNumber - 1; k++)
-	{
-		for (size_t fromId = 0; fromId < _adjacencyList.size(); ++fromId)
+		queued[currentId] = false;
+		queuedNumber--;
+		queuedDistances -= distance;
+		statistics.Expanded++;
+
+		for (const GraphArc& arc : _adjacencyList[currentId])
 		{
-			for (size_t to = 0; to < _adjacencyList[fromId].size(); ++to)
+			int toId = arc.To;
+			int new_distance = distance + arc.Weight;
+			int old_distance = workspace.GetDistance(toId);
+			if (old_distance <= new_distance)
+			{
+				continue;
+			}
+
+			if (depths[toId] >= 0)
 			{
-				shared_ptr<Cell> toCell = _adjacencyList[fromId][to];
-				int toId = toCell->GetId();
-				int weight_vu = _GetWeight(toCell->GetSymbol());
+				// Take the subtree of toId apart: none of its distances is shortest any more.
+				int subtreeEnd = treeNext[toId];
+				while (subtreeEnd != -1 && depths[subtreeEnd] > depths[toId])
+				{
+					if (subtreeEnd == currentId)
+					{
+						hasNegativeCycle = true;
+						break;
+					}
+
+					depths[subtreeEnd] = -1;
+					if (queued[subtreeEnd])
+					{
+						queued[subtreeEnd] = false;
+						queuedNumber--;
+						queuedDistances -= workspace.GetDistance(subtreeEnd);
+					}
+
+					subtreeEnd = treeNext[subtreeEnd];
+				}
+
+				if (hasNegativeCycle)
+				{
+					break;
+				}
 
-				if (shortestPath[toId] > shortestPath[fromId] + weight_vu)
+				// Start is the root, so any other vertex of the tree has the previous one.
+				treeNext[treePrevious[toId]] = subtreeEnd;
+				if (subtreeEnd != -1)
 				{
-					shortestPath[toId] = NEG_INF;
-					previousVertex[toId] = -2;
-					hasNegativeCycle = true;
+					treePrevious[subtreeEnd] = treePrevious[toId];
 				}
 			}
+
+			// Hang toId on the current vertex: right after it in preorder.
+			treePrevious[toId] = currentId;
+			treeNext[toId] = treeNext[currentId];
+			if (treeNext[currentId] != -1)
+			{
+				treePrevious[treeNext[currentId]] = toId;
+			}
+			treeNext[currentId] = toId;
+			depths[toId] = depths[currentId] + 1;
+
+			workspace.Visit(toId, new_distance, currentId);
+
+			if (queued[toId])
+			{
+				queuedDistances -= old_distance - new_distance;
+				continue;
+			}
+
+			queued[toId] = true;
+			queuedNumber++;
+			queuedDistances += new_distance;
+			statistics.Generated++;
+
+			if (!q.empty() && new_distance < workspace.GetDistance(q.front()))
+			{
+				q.push_front(toId);
+			}
+			else
+			{
+				q.push_back(toId);
+			}
 		}
 	}
 
-	// Reconstruct the path.
-	std::vector<std::shared_ptr<Cell>> result;
-
-	int destinationCellId = _grid[y2][x2]->GetId();
+	if (hasNegativeCycle)
+	{
+		cout << "Graph representation of the map contains negative cycles reachable from the start. There is no shortest path to the finish." << endl;
+		return std::make_tuple(true, std::vector<int>());
+	}
 
-	if (shortestPath[destinationCellId] == NEG_INF)
+	if (!workspace.IsVisited(finishId))
 	{
-		cout << "Graph representation of the map contains negative cycles. There is infinite number of shortest paths between the start and finish." << endl;
+		return std::make_tuple(false, std::vector<int>());
 	}
-	else
+
+	return std::make_tuple(false, _RetrievePathCellIds(finishId, workspace));
+}
+
+/// <summary>
+/// Bellman-Ford as passes over the whole edge list (see EdgeList::Relax): no queue, every pass streams all arcs.
+/// Stops early once a pass relaxes nothing. If distances still decrease in the pass after V - 1 ones, a negative cycle
+/// is reachable from the start. Passes and early exits are counted in the search statistics of the thread.
+/// </summary>
+std::tuple<bool, std::vector<int>> RectangularMap::_GetPathByBellmanFordEdgesList(int x1, int y1, int x2, int y2) const
+{
+	int verticesNumber = _edgesList.GetVerticesNumber();
+
+	// Passes gather distances by vertex id, so they use the arrays of the workspace as they are, without its generations.
+	// Arrays are allocated once per thread and map size, only filled again for every search.
+	SearchWorkspace& workspace = SearchWorkspace::ForCurrentThread();
+	workspace.BeginPlain(verticesNumber);
+	int32_t* distances = workspace.GetDistances();
+	int32_t* previous = workspace.GetPreviousVertices();
+	SearchStatistics& statistics = workspace.GetSearchStatistics();
+
+	int startId = GetVertexId(x1, y1);
+	int finishId = GetVertexId(x2, y2);
+	distances[startId] = 0;
+
+	// Shortest paths have V - 1 arcs at most, one more pass tells whether distances still decrease.
+	bool hasNegativeCycle = true;
+	for (int pass = 0; pass < verticesNumber; pass++)
 	{
-		std::vector<int> path;
-		for (int v = destinationCellId; v != startId && v != -1 && v != -2; v = previousVertex[v])
+		statistics.Passes++;
+		if (!_edgesList.Relax(distances, previous))
 		{
-			path.push_back(v);
+			statistics.EarlyExits++;
+			hasNegativeCycle = false;
+			break;
 		}
-		std::reverse(path.begin(), path.end());
+	}
 
-		// Convert to list of Cells.
-		for (auto& v : path)
+	if (hasNegativeCycle)
+	{
+		cout << "Graph representation of the map contains negative cycles reachable from the start. There is no shortest path to the finish." << endl;
+		return std::make_tuple(true, std::vector<int>());
+	}
+
+	std::vector<int> path;
+	if (distances[finishId] < INF)
+	{
+		for (int v = finishId; v != -1; v = previous[v])
 		{
-			if (v >= 0 && v < _moveableCells.size())
-				result.push_back(_moveableCells[v]);
-			else
-				break;
+			path.push_back(v);
 		}
+		std::reverse(path.begin(), path.end());
 	}
 
-	return std::make_tuple(hasNegativeCycle, result);
+	return std::make_tuple(false, path);
 }
 
-//std::tuple<bool, std::vector<std::shared_ptr<Cell>>> RectangularMap::_GetPathByBellmanFordEdgesList(int x1, int y1, int x2, int y2) const
-//{
-//	int n = _edgesList.size();
-//	vector<int> shortestPath(n, INF); // Shortest distance from Start to i
-//	vector<int> previousVertex(n, -1); // Previous node in shortest path to i.
-//
-//	shared_ptr<Cell> startCell = GetCellFromGrid(y1, x1);
-//	int startId = startCell->GetId();
-//	shortestPath[startId] = 0;
-//
-//	// Only in the worst case does it take V-1 iterations for the Bellman-Ford
-//	// algorithm to complete. Another stopping condition is when we're unable to
-//	// relax an edge, this means we have reached the optimal solution early.
-//	bool relaxedAnEdge = false;
-//
-//	// For each vertex, apply relaxation for all the edges
-//	for (int v = 0; v < n - 1 && relaxedAnEdge; v++)
-//	{
-//		for (shared_ptr<Edge> edge : _edgesList)
-//		{
-//			int toId = edge->GetToId();
-//			int fromId = edge->GetFromId();
-//			if (shortestPath[toId] > shortestPath[fromId] + edge->GetWeight())
-//			{
-//				shortestPath[toId] = shortestPath[fromId] + edge->GetWeight();
-//				previousVertex[toId] = fromId;
-//			}
-//		}
-//	}
-//
-//	// Run algorithm a second time to detect which nodes are part
-//	// of a negative cycle. A negative cycle has occurred if we
-//	// can find a better path beyond the optimal solution.
-//	relaxedAnEdge = false;
-//	for (int v = 0; v < n - 1 && relaxedAnEdge; v++)
-//	{
-//		relaxedAnEdge = false;
-//		for (shared_ptr< Edge> edge : _edgesList)
-//		{
-//			int toId = edge->GetToId();
-//			if (shortestPath[toId] > shortestPath[edge->GetFromId()] + edge->GetWeight())
-//			{
-//				shortestPath[toId] = NEG_INF;
-//				previousVertex[toId] = -1;
-//				relaxedAnEdge = true;
-//				break;
-//			}
-//		}
-// 
-//		if (relaxedAnEdge)
-//			break;
-//	}
-//
-//	std::vector<int> path;
-//	int destinationCellId = _grid[y2][x2]->GetId();
-//	for (int v = destinationCellId; v != startId && v != -1; v = previousVertex[v])
-//	{
-//		path.push_back(v);
-//	}
-//	std::reverse(path.begin(), path.end());
-//
-//	// Convert to list of Cells.
-//	std::vector<std::shared_ptr<Cell>> result;
-//	for (auto& v : path)
-//	{
-//		if (v >= 0 && v < _moveableCells.size())
-//			result.push_back(_moveableCells[v]);
-//		else
-//			return {};
-//	}
-//  return std::make_tuple(relaxedAnEdge, result);
-//}
-
 /// <summary>
-/// BFS works only for non-weightened graphs, which is exactly what I have here in the Grid.
-/// Additionally, I converted grid into Adjacency List and trying to use it to find the path.
+/// Bidirectional BFS for non-weightened (and so undirected) graphs: grows BFS levels from both ends,
+/// every time expanding the smaller frontier, and stops as soon as the frontiers meet.
 /// </summary>
-std::vector<std::shared_ptr<Cell>> RectangularMap::_GetPathByBFSOnGraph(int x1, int y1, int x2, int y2) const
+template <typename TGraph>
+std::vector<int> RectangularMap::_GetPathByBidirectionalBFS(const TGraph& graph, int x1, int y1, int x2, int y2) const
 {
-	std::vector<shared_ptr<Cell>> result;
-
 	if (x1 == x2 && y1 == y2)
 	{
-		return result;
+		return {};
 	}
 
-	// Convert current Rover position X, Y into Cells?
-	shared_ptr<Cell> startCell = GetCellFromGrid(y1, x1);
-	shared_ptr<Cell> endCell = GetCellFromGrid(y2, x2);
+	int startId = GetVertexId(x1, y1);
+	int endId = GetVertexId(x2, y2);
 
-	int n = _adjacencyList.size();
+	// Both searches keep previous vertices in the same workspace: until they meet, every vertex belongs to one side only.
+	SearchWorkspace& workspace = SearchWorkspace::ForCurrentThread();
+	workspace.Begin(graph.GetVerticesNumber());
 
-	vector<bool> visited(n, false);
-	vector<int> dist(n, -1);
-	vector<int> path(n, -1);
-
-	int startId = startCell->GetId();
-
-	queue<shared_ptr<Cell>> queue;
-	queue.push(startCell);
+	int ids[2] = { startId, endId };
+	size_t heads[2] = { 0, 0 };
+	for (int side = 0; side < 2; side++)
+	{
+		workspace.GetQueue(side).push_back(ids[side]);
+		workspace.GetVisited(side).Set(ids[side]);
+		workspace.Visit(ids[side], 0, -2);
+	}
 
-	visited[startId] = true;
-	path[startId] = -2;
+	// Arc connecting forward and backward search trees.
+	int meetFromId = -1;
+	int meetToId = -1;
 
-	while (!queue.empty())
+	while (meetFromId == -1 &&
+		heads[0] < workspace.GetQueue(0).size() &&
+		heads[1] < workspace.GetQueue(1).size())
 	{
-		shared_ptr<Cell> v = queue.front();
-		queue.pop();
-		int adjIndex = v->GetId(); // We set it during Graph Init.
+		// Expand the whole level of the smaller frontier.
+		int side = (workspace.GetQueue(0).size() - heads[0] <= workspace.GetQueue(1).size() - heads[1]) ? 0 : 1;
 
-		for (size_t i = 0; i < _adjacencyList[adjIndex].size(); ++i)
+		std::vector<int>& queue = workspace.GetQueue(side);
+		VisitedSet& visited = workspace.GetVisited(side);
+		const VisitedSet& otherVisited = workspace.GetVisited(1 - side);
+		size_t levelEnd = queue.size();
+
+		for (; heads[side] < levelEnd && meetFromId == -1; heads[side]++)
 		{
-			shared_ptr<Cell> to = _adjacencyList[adjIndex][i];
-			int toIndex = to->GetId();
+			int currentId = queue[heads[side]];
 
-			if (!visited[toIndex])
+			graph.ForEachArc(currentId, [&](int toId, int)
 			{
-				visited[toIndex] = true;
-				queue.push(to);
-
-				if (dist[adjIndex] == -1)
+				if (meetFromId != -1 || visited.Test(toId))
 				{
-					dist[adjIndex] = 0;
+					return;
 				}
 
-				dist[toIndex] = dist[adjIndex] + 1;
-				path[toIndex] = adjIndex;
+				if (otherVisited.Test(toId))
+				{
+					meetFromId = side == 0 ? currentId : toId;
+					meetToId = side == 0 ? toId : currentId;
+					return;
+				}
 
-				//if (dist[toIndex] >= max) // If we move out of limits (MAX)
-				//{
-				//	remember path, dist and visited, and exit.
-				//	return;
-				//}
-			}
+				visited.Set(toId);
+				workspace.Visit(toId, workspace.GetDistance(currentId) + 1, currentId);
+				queue.push_back(toId);
+			});
 		}
 	}
 
- 	std::vector<int> resultInd = _RetrievePathCellIds(endCell->GetId(), path);
+	if (meetFromId == -1)
+	{
+		return {};
+	}
 
-	// Convert to list of Cells.
-  	for (auto& v : resultInd)
+	// Start .. meetFromId comes from the forward tree, meetToId .. end from the backward one.
+	std::vector<int> path = _RetrievePathCellIds(meetFromId, workspace);
+	for (int v = meetToId; v != -2; v = workspace.GetPrevious(v))
 	{
-		if (v >= 0 && v < _moveableCells.size())
-			result.push_back(_moveableCells[v]);
-		else
-			return {};
+		path.push_back(v);
 	}
 
-	return result;
+	return path;
 }
 
-std::vector<int> RectangularMap::_RetrievePathCellIds(int destinationCellId, const vector<int> paths) const
+std::vector<int> RectangularMap::_RetrievePathCellIds(int destinationCellId, const SearchWorkspace& workspace) const
 {
 	std::vector<int> path;
-	for (int v = destinationCellId; v != -2; v = paths[v])
+	for (int v = destinationCellId; v != -2; v = workspace.GetPrevious(v))
 	{
 		if (v == -1)
 			break;
@@ -686,30 +1213,32 @@ string RectangularMap::_TryGetDirections(const vector<int> path) const // , cons
 {
 	string route;
 
-	if (path[0] >= _moveableCells.size() || path[0] < 0)
+	if (path[0] < 0 || (size_t)path[0] >= _vertexCells.GetSize())
 		return route;
 
 	int position = 0; // startPoint;
-	auto last = _moveableCells[path[0]];
+	int lastX, lastY;
+	std::tie(lastX, lastY) = GetVertexCoordinate(path[0]);
 
 	for (size_t i = 1; i < path.size(); ++i)
 	{
 		if (path[i] >= 0)
 			return route;
 
-		auto cell = _moveableCells[path[i]];
+		int x, y;
+		std::tie(x, y) = GetVertexCoordinate(path[i]);
 
-		if (cell->GetY() > last->GetY())
+		if (y > lastY)
 		{
 			route[position] = 'D';
 		}
-		else if (cell->GetY() < last->GetY())
+		else if (y < lastY)
 		{
 			route[position] = 'U';
 		}
 		else
 		{
-			if (cell->GetX() > last->GetY())
+			if (x > lastY)
 			{
 				route[position] = 'R';
 			}
@@ -719,7 +1248,8 @@ string RectangularMap::_TryGetDirections(const vector<int> path) const // , cons
 			}
 		}
 
-		last = cell;
+		lastX = x;
+		lastY = y;
 		++position;
 
 		if (position >= path.size())
@@ -732,125 +1262,16 @@ string RectangularMap::_TryGetDirections(const vector<int> path) const // , cons
 	return route;
 }
 
-/// <summary>
-/// BFS works only for non-weightened graphs, which is exactly what I have here in the Grid.
-/// This method implements BFS right on  the Grid, without using any other graph representation.
-/// </summary>
-std::vector<std::shared_ptr<Cell>> RectangularMap::_GetPathByBFSOnGrid(int x1, int y1, int x2, int y2) const
-{
-	std::vector<shared_ptr<Cell>> result;
-
-	if (x1 == x2 && y1 == y2)
-	{
-		return result;
-	}
-
-	// Two queues for two coordinates (X, Y). Queues updated synchronously.
-	queue<int> xQueue;
-	queue<int> yQueue;
-
-	vector<vector<bool>> visited(_width, vector<bool>(_height));
-
-	int n = _width * _height;
-	vector<int> dist(n, -1);
-	vector<int> path(n, -1);
-
-	bool atDestination = false;
-
-	xQueue.push(x1); // Start x
-	yQueue.push(y1); // Start y
-
-	visited[y1][x1] = true;
- 	path[x1 + _width * y1] = -2;
-
-	vector<int> dr{ -1, +1, 0, 0 }; // Row
-	vector<int> dc{ 0, 0, -1, +1 }; // Column
-
-	// Find paths to all cells by BFS until we reach the goal cell.
-	while (!xQueue.empty() && !yQueue.empty())
-	{
-		int curX = xQueue.front();
-		int curY = yQueue.front();
-		xQueue.pop();
-		yQueue.pop();
-
-		if (curX == x2 && curY == y2)
-		{
-			atDestination = true;
-			break;
-		}
-
-		int v = curX + curY * _width;
-
-		// Add all neighbour cells into queues:
-		// Left cell (rr - 1, cc)
-		// Right cell (rr + 1, cc)
-		// Up cell (rr, cc - 1)
-		// Down cell (rr, cc + 1)
-		for (int i = 0; i < 4; i++)
-		{
-			int r = curY + dr[i]; // Remember! X, Y and Row, Column - are opposite terms.
-			int c = curX + dc[i];
-
-			if (r >= 0 && c >= 0 && 
-				r < _width && c < _height &&
-				visited[r][c] == false &&
-				_grid[r][c]->GetId() > -1 && _grid[r][c]->GetSymbol() != '#') // Avoid blocks
-			{
-				xQueue.push(c);
-				yQueue.push(r);
-				visited[r][c] = true;
-
-				if (dist[v] == -1)
-				{
-					dist[v] = 0;
-				}
-
-				int to = c + r * _width;
-				dist[to] = dist[v] + 1;
-				path[to] = v;
-			}
-		}
-	}
-
-	//for (int i = 0; i < _width; i++)
-	//{
-	//	for (int j = 0; j < _height; j++)
-	//	{
-	//		cout << visited[i][j] << " ,";
-	//	}
-
-	//	cout << " ;" << endl;
-	//}
-
-	// Since we found destination, now we need to reconstruct the path to it.
-	if (atDestination)
-	{
-		std::vector<int> resultInd = _RetrievePathCellIds(x2 + _width * y2, path);
-
-		// Convert to list of Cells.
-		for (auto& v : resultInd)
-		{
-			int y = v / _width;
-			int x = v - y * _width;
-
-			result.push_back(_grid[y][x]);
-		}
-	}
-
-	return result;
-}
-
 ///////////////////////////////////////////////////////////////////// For DAGs only /////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////// Not aplicable for this app ///////////////////////////////////////////
 
 /// <summary>
 /// Find shortest distance lengths to every node from given starting node. Works on weighten graphs even with negative weights.
 /// </summary>
-std::vector<int> RectangularMap::_GetSingleSourceShortedPaths(int x1, int y1) const
+std::vector<int> RectangularMap::_GetSingleSourceShortedPaths(int x1, int y1, int weightSign) const
 {
 	// FIRST: topologically sort Cells
-	std::vector<std::shared_ptr<Cell>> topSorted = _TopologicalSortCyclesProtected(_adjacencyList);
+	std::vector<int> topSorted = _TopologicalSortCyclesProtected(_adjacencyList);
 
 	// OR Alternatively we can do this:
 	//if (_IsDAGbyTarjansStronglyComponent(_adjacencyList)) // TODO Not yet implemented // Check if it is DAG
@@ -868,20 +1289,17 @@ std::vector<int> RectangularMap::_GetSingleSourceShortedPaths(int x1, int y1) co
 
 	// Now, find MINIMAL distance to EVERY CELL.
 	std::vector<int> dist = std::vector<int>(_verticesNumber, -1);
-	int startId = _grid[y1][x1]->GetId();
+	int startId = GetVertexId(x1, y1);
 	dist[startId] = 0;
 
-	for (auto& cell : topSorted)
+	for (auto& fromId : topSorted)
 	{
-		int fromId = cell->GetId();
-
 		if (dist[fromId] != -1)
 		{
-			for (auto toCell : _adjacencyList[fromId])
+			for (const GraphArc& arc : _adjacencyList[fromId])
 			{
-				int newDist = dist[fromId] + _GetWeight(toCell->GetSymbol());
-
-				int toId = toCell->GetId();
+				int toId = arc.To;
+				int newDist = dist[fromId] + weightSign * arc.Weight;
 
 				if (dist[toId] == -1)
 				{
@@ -931,28 +1349,14 @@ std::vector<int> RectangularMap::_GetSingleSourceShortedPaths(int x1, int y1) co
 /// </summary>
 std::vector<int> RectangularMap::_GetSingleSourceLongestPaths(int x1, int y1) const
 {
-	// FIRST: multiply all weights to -1
-	for (auto& cell : _moveableCells)
-	{
-		cell->SetWeight(cell->GetWeight() * -1); // Potentiall corruptive, if exception happens.
-	}
-
-	// SECOND: find SSSP
-	std::vector<int> distances = _GetSingleSourceShortedPaths(x1, y1);
-
-	// THIRD: multiply all weights to -1 again
-	for (auto& cell : _moveableCells)
-	{
-		cell->SetWeight(cell->GetWeight() * -1);
-	}
-
-	return distances;
+	// Multiply all weights to -1 and find SSSP.
+	return _GetSingleSourceShortedPaths(x1, y1, -1);
 }
 
 /// <summary>
 /// Sort by time of exit from each node during DFS.
 /// </summary>
-std::vector<std::shared_ptr<Cell>> RectangularMap::_TopologicalSortByDFS(Graph graph) const // TODO
+std::vector<int> RectangularMap::_TopologicalSortByDFS(const Graph& graph) const // TODO
 {
 	std::vector<bool> visited(_verticesNumber, false);
 	std::vector<int> sorted(_verticesNumber);
@@ -962,31 +1366,27 @@ std::vector<std::shared_ptr<Cell>> RectangularMap::_TopologicalSortByDFS(Graph g
 		_TopologicalSortDFSExplore(i, graph, visited, sorted);
 	}
 
-	// Convert to list of Cells.
-	std::vector<std::shared_ptr<Cell>> result;
 	for (auto& v : sorted)
 	{
-		if (v >= 0 && v < _moveableCells.size()) // Guard
-			result.push_back(_moveableCells[v]);
-		else
+		if (v < 0 || (size_t)v >= _vertexCells.GetSize()) // Guard
 			return {};
 	}
 
-	return result;
+	return sorted;
 }
 
 /// <summary>
 /// DFS for topological sorting.
 /// </summary>
-void RectangularMap::_TopologicalSortDFSExplore(int cellId, Graph graph, std::vector<bool> visited, std::vector<int> sorted) const
+void RectangularMap::_TopologicalSortDFSExplore(int cellId, const Graph& graph, std::vector<bool> visited, std::vector<int> sorted) const
 {
 	visited[cellId] = true;
 
 	// Pre Visit Time.
 
-	for (auto cellId : graph[cellId])
+	for (const GraphArc& arc : graph[cellId])
 	{
-		int id = cellId->GetId();
+		int id = arc.To;
 
 		if (!visited[id])
 		{
@@ -1001,7 +1401,7 @@ void RectangularMap::_TopologicalSortDFSExplore(int cellId, Graph graph, std::ve
 /// <summary>
 /// Uses DFS with graph coloring algorithm to detect cycles.
 /// </summary>
-std::vector<std::shared_ptr<Cell>> RectangularMap::_TopologicalSortCyclesProtected(Graph graph) const
+std::vector<int> RectangularMap::_TopologicalSortCyclesProtected(const Graph& graph) const
 {
 	std::vector<int> sorted(_verticesNumber);
 
@@ -1012,7 +1412,7 @@ std::vector<std::shared_ptr<Cell>> RectangularMap::_TopologicalSortCyclesProtect
 	vector<int> visited(_verticesNumber, WHITE);
 
 	std::stack<int> stack;
-	int start = graph[0][0]->GetId();
+	int start = graph[0][0].To;
 	stack.push(start);
 	visited[start] = GREY;
 
@@ -1025,9 +1425,9 @@ std::vector<std::shared_ptr<Cell>> RectangularMap::_TopologicalSortCyclesProtect
 
 		if (visited[v] == GREY) // Current item to handle!
 		{
-			for (int i = 0; i < graph[v].size(); i++)
+			for (const GraphArc& arc : graph[v])
 			{
-				int neighbourTo = graph[v][i]->GetId();
+				int neighbourTo = arc.To;
 				if (visited[neighbourTo] == WHITE) // NOT yet  visited
 				{
 					stack.push(neighbourTo);
@@ -1044,15 +1444,11 @@ std::vector<std::shared_ptr<Cell>> RectangularMap::_TopologicalSortCyclesProtect
 		}
 	}
 
-	// Convert to list of Cells.
-	std::vector<std::shared_ptr<Cell>> result;
 	for (auto& v : sorted)
 	{
-		if (v >= 0 && v < _moveableCells.size()) // Guard
-			result.push_back(_moveableCells[v]);
-		else
+		if (v < 0 || (size_t)v >= _vertexCells.GetSize()) // Guard
 			return {};
 	}
 
-	return result;
+	return sorted;
 }
@@ -2,6 +2,10 @@
 #define __RectangularMap_h__
 
 #include "mapbase.h"
+#include "searchworkspace.h"
+#include "searchqueue.h"
+#include "searchheuristic.h"
+#include <string_view>
 
 class RectangularMap : public MapBase
 {
@@ -13,7 +17,7 @@ public:
 	 */
 	virtual void InitialiseGraph();
 
-	virtual bool MapBase::LoadMap(const std::string& filepath, bool shadow);
+	virtual bool LoadMap(const std::string& filepath, bool shadow);
 
 	virtual bool IsReady();
 
@@ -21,40 +25,88 @@ public:
 
 public:
 	virtual std::tuple<float, float, float, float> GetCoordinateBounds() const;
-	virtual std::vector<std::shared_ptr<Cell>> GetPath(int x1, int y1, int x2, int y2) const;
+	virtual std::vector<Coordinate> GetPath(int x1, int y1, int x2, int y2) const;
 
 private:
 	void _Scale(int width, int height);
 
 	/// <summary>
-	/// BFS works only for non-weightened graphs, which is exactly what I have here in the Grid 
-	/// defined in some files where I have only 2 states: block and grass.
-	/// Additionally, I converted grid into Adjacency List and trying to use it to find the path.
+	/// Classifies symbols of the rows into the terrain and numbers moveable cells in row-major order.
+	/// Large maps are processed by several threads with exactly the same result.
 	/// </summary>
-	std::vector<std::shared_ptr<Cell>> _GetPathByBFSOnGraph(int x1, int y1, int x2, int y2) const;
-	std::vector<int> _RetrievePathCellIds(int destinationCellId, const vector<int> paths) const;
+	void _FillTerrain(const std::vector<std::string_view>& rows);
 
 	/// <summary>
-	/// BFS works only for non-weightened graphs, which is exactly what I have here in the Grid 
-	/// defined in some files where I have only 2 states: block and grass.
-	/// This method implements BFS right on the Grid, without using any other graph representation.
+	/// Loads JPS+ jump distances saved next to the map file, or computes and saves them if there are none for this terrain.
 	/// </summary>
-	std::vector<std::shared_ptr<Cell>> _GetPathByBFSOnGrid(int x1, int y1, int x2, int y2) const;
+	void _InitialiseJumpDistances(const std::string& mapFilepath);
 
-	string _TryGetDirections(const vector<int> path) const;
-	int _VertexIndex(int row, int column);
+	/// <summary>
+	/// Runs func on the graph representation selected for the map: implicit grid (GridGraph) or adjacency list (Graph).
+	/// Path finding algorithms are templates, so they work with both.
+	/// </summary>
+	template <typename TFunc>
+	auto _WithGraph(TFunc&& func) const;
+
+	/// <summary>
+	/// Same as _WithGraph, but passes reversed graph as well: func(graph, reverseGraph). For bidirectional searches.
+	/// </summary>
+	template <typename TFunc>
+	auto _WithGraphs(TFunc&& func) const;
 
 	/// <summary>
-	/// Single source shortest path algorithm for weighten graphs that cannot deal with negative weights.
-	/// O((E+V)log(V))
+	/// Runs func with an empty queue of the type selected for the map: func(BucketQueue()) for small integer weights,
+	/// func(RadixHeapQueue()) otherwise. Searches take the type of the queue as a template parameter.
 	/// </summary>
-	std::vector<std::shared_ptr<Cell>> _GetPathByDijkstra(int x1, int y1, int x2, int y2) const;
+	template <typename TFunc>
+	auto _WithQueue(TFunc&& func) const;
+
+	/// <summary>
+	/// Runs func with the heuristic selected for the map, e.g. func(ManhattanHeuristic()).
+	/// A* searches take the type of the heuristic as a template parameter.
+	/// </summary>
+	template <typename TFunc>
+	auto _WithHeuristic(TFunc&& func) const;
+
+	/// <summary>
+	/// Estimate function of THeuristic: lower bound of the distance from a vertex to vertexId if toVertex is set,
+	/// otherwise from vertexId to a vertex. Geometric estimates are measured in steps and scaled by the cheapest step cost.
+	/// </summary>
+	template <typename THeuristic>
+	auto _GetEstimate(int vertexId, bool toVertex) const;
+
+	/// <summary>
+	/// Largest change of the THeuristic estimate per step: one cheapest step for geometric estimates, the heaviest one for landmarks.
+	/// </summary>
+	template <typename THeuristic>
+	int _GetEstimateStep() const;
+
+	std::vector<int> _RetrievePathCellIds(int destinationCellId, const SearchWorkspace& workspace) const;
+
+	/// <summary>
+	/// Bidirectional BFS for non-weightened (and so undirected) graphs: grows BFS levels from both ends,
+	/// every time expanding the smaller frontier, and stops as soon as the frontiers meet.
+	/// </summary>
+	template <typename TGraph>
+	std::vector<int> _GetPathByBidirectionalBFS(const TGraph& graph, int x1, int y1, int x2, int y2) const;
+
+	string _TryGetDirections(const vector<int> path) const;
+	int _VertexIndex(int row, int column);
 
 	/// <summary>
 	/// Single source shortest path algorithm for weighten graphs with additional heuristic to speed up search.
 	/// However, it still cannot deal with negative weights.
 	/// </summary>
-	std::vector<std::shared_ptr<Cell>> _GetPathByAStar(int x1, int y1, int x2, int y2) const;
+	template <typename TQueue, typename THeuristic, typename TGraph>
+	std::vector<int> _GetPathByAStar(const TGraph& graph, int x1, int y1, int x2, int y2) const;
+
+	/// <summary>
+	/// Bidirectional A* for weighten graphs without negative weights (bidirectional Dijkstra with ZeroHeuristic).
+	/// Runs forward search on graph and backward search on reverseGraph until they meet.
+	/// </summary>
+	template <typename TQueue, typename THeuristic, typename TGraph, typename TReverseGraph>
+	std::vector<int> _GetPathByBidirectionalSearch(const TGraph& graph, const TReverseGraph& reverseGraph,
+		int x1, int y1, int x2, int y2) const;
 
 	/// <summary>
 	/// Gets weight of edge.
@@ -63,15 +115,17 @@ private:
 
 	/// <summary>
 	/// Single source shortest path algorithm for weighten graphs that easily handles Negative-weights in a graph.
-	/// Works using adjacency list. O((E*V)) - worse than Dijkstra.
+	/// Works using adjacency list: queue-based (SPFA) with SLF/LLL ordering and Tarjan's subtree disassembly for negative cycles.
+	/// O((E*V)) in the worst case, close to linear on grids. Returns whether a negative cycle is reachable from the start
+	/// and the path (empty if there is a cycle or the finish is not reachable).
 	/// </summary>
-	std::tuple<bool, std::vector<std::shared_ptr<Cell>>> _GetPathByBellmanFord(int x1, int y1, int x2, int y2) const;
+	std::tuple<bool, std::vector<int>> _GetPathByBellmanFord(int x1, int y1, int x2, int y2) const;
 
 	/// <summary>
 	/// Single source shortest path algorithm for weighten graphs that easily handles Negative-weights in a graph.
-	/// Using Edges list. O((E*V)) - worse than Dijkstra.
+	/// Using Edges list: passes over all arcs until one relaxes nothing. O((E*V)) - worse than Dijkstra.
 	/// </summary>
-	//std::tuple<bool, std::vector<std::shared_ptr<Cell>>> _GetPathByBellmanFordEdgesList(int x1, int y1, int x2, int y2) const;
+	std::tuple<bool, std::vector<int>> _GetPathByBellmanFordEdgesList(int x1, int y1, int x2, int y2) const;
 
 private:
 ///////////////////////////////////////////////////////////////////////// For DAGs only /////////////////////////////////////////////////////
@@ -80,9 +134,9 @@ private:
 
 	/// <summary>
 	/// Single source shortest path algorithm to find shortest distance lengths to every node from given starting node. 
-	/// Works on weighten graphs even with negative weights.
+	/// Works on weighten graphs even with negative weights. Weights of all edges are multiplied by weightSign.
 	/// </summary>
-	std::vector<int> _GetSingleSourceShortedPaths(int x1, int y1) const;
+	std::vector<int> _GetSingleSourceShortedPaths(int x1, int y1, int weightSign = 1) const;
 
 	/// <summary>
 	/// Single source shortest path algorithm to find longest distance lengths to every node from given starting node. 
@@ -93,17 +147,17 @@ private:
 	/// <summary>
 	/// Sort by time of exit from each node during DFS.
 	/// </summary>
-	std::vector<std::shared_ptr<Cell>> _TopologicalSortByDFS(Graph graph) const;
+	std::vector<int> _TopologicalSortByDFS(const Graph& graph) const;
 
 	/// <summary>
 	/// DFS for topological sorting.
 	/// </summary>
-	void _TopologicalSortDFSExplore(int startCellId, Graph graph, std::vector<bool> visited, std::vector<int> sorted) const;
+	void _TopologicalSortDFSExplore(int startCellId, const Graph& graph, std::vector<bool> visited, std::vector<int> sorted) const;
 
 	/// <summary>
 	/// Uses DFS with graph coloring algorithm to detect cycles.
 	/// </summary>
-	std::vector<std::shared_ptr<Cell>> _TopologicalSortCyclesProtected(Graph graph) const;
+	std::vector<int> _TopologicalSortCyclesProtected(const Graph& graph) const;
 
 private:
 	bool _mapLoaded;
@@ -2,7 +2,7 @@
 #ifndef __Rover_h__
 #define __Rover_h__
 
-#include "cellbase.h"
+#include "common.h"
 
 class Rover
 {
@@ -12,9 +12,6 @@ public:
 
     string route = DEFAULT_ROUTE;
 
-    vector<int> dist;
-    vector<int> path;
-    vector<bool> visited;
     vector<int> pathToTake;
     vector<int> pathToPut;
 };
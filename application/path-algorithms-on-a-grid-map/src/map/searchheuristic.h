@@ -0,0 +1,95 @@
+#ifndef SEARCHHEURISTIC_H
+#define SEARCHHEURISTIC_H
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+
+// Distance estimates of A* searches. Searches take the heuristic type as a template parameter, so the estimate is inlined:
+//   Estimate(dx, dy) - lower bound of the number of steps between cells dx columns and dy rows apart (dx, dy >= 0).
+// Searches multiply the estimate by the cheapest step cost of the map, so it stays admissible for any terrain.
+// All estimates are integer and change by 1 at most per step of the 4-connected grid, so they are consistent there.
+
+/// <summary>
+/// Exact number of steps of the 4-connected grid without blocks. The strongest admissible estimate for this map.
+/// </summary>
+struct ManhattanHeuristic
+{
+	static int Estimate(int dx, int dy)
+	{
+		return dx + dy;
+	}
+};
+
+/// <summary>
+/// Number of steps of the 8-connected grid, where diagonal step costs sqrt(2): max + (sqrt(2) - 1) * min,
+/// rounded down in thousandths. Weaker than Manhattan on the 4-connected grid, but admissible there as well.
+/// </summary>
+struct OctileHeuristic
+{
+	static int Estimate(int dx, int dy)
+	{
+		int64_t longSide = std::max(dx, dy);
+		int64_t shortSide = std::min(dx, dy);
+
+		return (int)((longSide * 1000 + shortSide * 414) / 1000);
+	}
+};
+
+/// <summary>
+/// Straight line distance, rounded down with integer square root.
+/// </summary>
+struct EuclideanHeuristic
+{
+	static int Estimate(int dx, int dy)
+	{
+		uint64_t square = (uint64_t)dx * dx + (uint64_t)dy * dy;
+
+		if (square == 0)
+		{
+			return 0;
+		}
+
+		// Bit by bit square root: largest root with root * root <= square. Starts from the highest even bit of square.
+		uint64_t root = 0;
+		uint64_t bit = 1ull << ((std::bit_width(square) - 1) & ~1);
+
+		while (bit != 0)
+		{
+			if (square >= root + bit)
+			{
+				square -= root + bit;
+				root = (root >> 1) + bit;
+			}
+			else
+			{
+				root >>= 1;
+			}
+
+			bit >>= 2;
+		}
+
+		return (int)root;
+	}
+};
+
+/// <summary>
+/// No estimate: A* becomes Dijkstra.
+/// </summary>
+struct ZeroHeuristic
+{
+	static int Estimate([[maybe_unused]] int dx, [[maybe_unused]] int dy)
+	{
+		return 0;
+	}
+};
+
+/// <summary>
+/// Lower bound from the distances to landmarks (ALT, see LandmarkTable). It depends on the vertices, not on their offsets,
+/// so searches take it from the landmark table of the map. Already measured in costs, and changes by an arc weight at most per step.
+/// </summary>
+struct LandmarkHeuristic
+{
+};
+
+#endif
@@ -0,0 +1,482 @@
+#ifndef SEARCHQUEUE_H
+#define SEARCHQUEUE_H
+
+#include "common.h"
+#include <bit>
+#include <cstdint>
+#include <queue>
+#include <tuple>
+
+// Priority queues (open lists) of vertex ids for Dijkstra-like searches. All of them have the same interface, so searches take
+// the queue type as a template parameter:
+//   Reset(verticesNumber, maxKeyStep, orderTies) - empties the queue before a search;
+//   Update(key, vertexId, tieKey)                - adds the vertex, or lowers its key if it is already queued;
+//   GetTopKey(), Pop()                           - smallest key and its vertex;
+//   IsEmpty(), GetSize(), GetStatistics().
+// Queues with lazy deletion (HeapQueue, BucketQueue, RadixHeapQueue) cannot lower a key: they add one more item instead,
+// and searches skip outdated items when they are popped. IndexedHeapQueue really lowers the key, so it pops every vertex once.
+// Keys of updated items must not be less than the key of the last popped item (monotone queue),
+// and must not exceed it by more than maxKeyStep.
+// Items with equal keys pop in the order of tie keys (smallest first) if orderTies is set. Tie keys may go in any order,
+// so the monotone queues keep only the items of the smallest key ordered, as a heap. Otherwise heaps break ties by vertex id,
+// and the monotone queues pop equal keys last in, first out.
+
+/// <summary>
+/// Operation counters of a queue. Lazy deletion queues count every added item as push and every outdated item as pop.
+/// </summary>
+struct QueueStatistics
+{
+	uint64_t Pushes = 0;
+	uint64_t Pops = 0;
+	uint64_t DecreaseKeys = 0;
+
+	QueueStatistics& operator+=(const QueueStatistics& other)
+	{
+		Pushes += other.Pushes;
+		Pops += other.Pops;
+		DecreaseKeys += other.DecreaseKeys;
+		return *this;
+	}
+};
+
+/// <summary>
+/// Queue of the given type for the side of a search (0 - forward, 1 - backward), owned by the calling thread.
+/// Its buffers are allocated once per thread, like the ones of SearchWorkspace.
+/// </summary>
+template <typename TQueue>
+TQueue& GetQueueForCurrentThread(int side = 0)
+{
+	static thread_local TQueue queues[2];
+	return queues[side];
+}
+
+/// <summary>
+/// Binary heap with lazy deletion. O(log(n)) per push and pop, works for any weights.
+/// </summary>
+class HeapQueue
+{
+public:
+	void Reset([[maybe_unused]] int verticesNumber, [[maybe_unused]] int maxKeyStep, [[maybe_unused]] bool orderTies = false)
+	{
+		_heap.clear();
+		_statistics = {};
+	}
+
+	bool IsEmpty() const { return _heap.empty(); }
+	size_t GetSize() const { return _heap.size(); }
+	const QueueStatistics& GetStatistics() const { return _statistics; }
+
+	void Update(int key, int vertexId, int tieKey = 0)
+	{
+		_heap.push_back({ key, tieKey, vertexId });
+		std::push_heap(_heap.begin(), _heap.end(), std::greater<std::tuple<int, int, int>>());
+		_statistics.Pushes++;
+	}
+
+	int GetTopKey() const
+	{
+		return std::get<0>(_heap.front());
+	}
+
+	int Pop()
+	{
+		int vertexId = std::get<2>(_heap.front());
+		std::pop_heap(_heap.begin(), _heap.end(), std::greater<std::tuple<int, int, int>>());
+		_heap.pop_back();
+		_statistics.Pops++;
+		return vertexId;
+	}
+
+private:
+	std::vector<std::tuple<int, int, int>> _heap; // Key, tie key, vertex id.
+	QueueStatistics _statistics;
+};
+
+/// <summary>
+/// 4-ary heap with the position of every vertex in it, so the key of a queued vertex is lowered in place (true decrease-key).
+/// Never holds outdated items; the heap is shallower than the binary one and its children share a cache line.
+/// O(log(n)) per push, pop and decrease-key.
+/// </summary>
+class IndexedHeapQueue
+{
+public:
+	void Reset(int verticesNumber, [[maybe_unused]] int maxKeyStep, [[maybe_unused]] bool orderTies = false)
+	{
+		// Only vertices left in the heap by the previous search have positions set.
+		for (const Item& item : _heap)
+		{
+			_positions[item.VertexId] = -1;
+		}
+
+		_heap.clear();
+		if (_positions.size() < (size_t)verticesNumber)
+		{
+			_positions.resize(verticesNumber, -1);
+		}
+
+		_statistics = {};
+	}
+
+	bool IsEmpty() const { return _heap.empty(); }
+	size_t GetSize() const { return _heap.size(); }
+	const QueueStatistics& GetStatistics() const { return _statistics; }
+
+	void Update(int key, int vertexId, int tieKey = 0)
+	{
+		int position = _positions[vertexId];
+		if (position < 0)
+		{
+			_heap.push_back({ key, tieKey, vertexId });
+			_SiftUp((int)_heap.size() - 1);
+			_statistics.Pushes++;
+		}
+		else if (key < _heap[position].Key)
+		{
+			_heap[position].Key = key;
+			_heap[position].TieKey = tieKey;
+			_SiftUp(position);
+			_statistics.DecreaseKeys++;
+		}
+	}
+
+	int GetTopKey() const
+	{
+		return _heap.front().Key;
+	}
+
+	int Pop()
+	{
+		int vertexId = _heap.front().VertexId;
+		_positions[vertexId] = -1;
+
+		Item last = _heap.back();
+		_heap.pop_back();
+		if (!_heap.empty())
+		{
+			_heap[0] = last;
+			_positions[last.VertexId] = 0;
+			_SiftDown(0);
+		}
+
+		_statistics.Pops++;
+		return vertexId;
+	}
+
+private:
+	static const int ARITY = 4;
+
+	struct Item
+	{
+		int Key;
+		int TieKey;
+		int VertexId;
+	};
+
+	static bool _IsLess(const Item& left, const Item& right)
+	{
+		return left.Key < right.Key || (left.Key == right.Key && left.TieKey < right.TieKey);
+	}
+
+	void _SiftUp(int position)
+	{
+		Item item = _heap[position];
+		while (position > 0)
+		{
+			int parent = (position - 1) / ARITY;
+			if (!_IsLess(item, _heap[parent]))
+			{
+				break;
+			}
+
+			_heap[position] = _heap[parent];
+			_positions[_heap[position].VertexId] = position;
+			position = parent;
+		}
+
+		_heap[position] = item;
+		_positions[item.VertexId] = position;
+	}
+
+	void _SiftDown(int position)
+	{
+		Item item = _heap[position];
+		int size = (int)_heap.size();
+
+		while (true)
+		{
+			int firstChild = position * ARITY + 1;
+			if (firstChild >= size)
+			{
+				break;
+			}
+
+			int minChild = firstChild;
+			int lastChild = std::min(firstChild + ARITY, size);
+			for (int child = firstChild + 1; child < lastChild; child++)
+			{
+				if (_IsLess(_heap[child], _heap[minChild]))
+				{
+					minChild = child;
+				}
+			}
+
+			if (!_IsLess(_heap[minChild], item))
+			{
+				break;
+			}
+
+			_heap[position] = _heap[minChild];
+			_positions[_heap[position].VertexId] = position;
+			position = minChild;
+		}
+
+		_heap[position] = item;
+		_positions[item.VertexId] = position;
+	}
+
+private:
+	std::vector<Item> _heap;
+	std::vector<int> _positions; // Vertex id -> index in _heap, or -1 if vertex is not queued.
+	QueueStatistics _statistics;
+};
+
+/// <summary>
+/// Radix heap for monotone integer keys: item goes to bucket number (index of the highest bit where its key differs
+/// from the last popped key), so buckets cover growing ranges of keys. When bucket 0 (keys equal to the last popped one)
+/// is empty, the smallest key of the first non-empty bucket becomes the last popped key and the bucket is spread
+/// into the lower ones. Every item moves down at most 32 times: O(1) per push, amortized O(log(C)) per pop.
+/// </summary>
+class RadixHeapQueue
+{
+public:
+	RadixHeapQueue() : _size(0), _lastKey(0), _orderTies(false) {}
+
+	void Reset([[maybe_unused]] int verticesNumber, [[maybe_unused]] int maxKeyStep, bool orderTies = false)
+	{
+		for (auto& bucket : _buckets)
+		{
+			bucket.clear();
+		}
+
+		_size = 0;
+		_lastKey = 0;
+		_orderTies = orderTies;
+		_statistics = {};
+	}
+
+	bool IsEmpty() const { return _size == 0; }
+	size_t GetSize() const { return _size; }
+	const QueueStatistics& GetStatistics() const { return _statistics; }
+
+	void Update(int key, int vertexId, int tieKey = 0)
+	{
+		uint32_t radixKey = _ToRadixKey(key);
+		int bucket = _BucketIndex(radixKey);
+		_buckets[bucket].push_back({ radixKey, tieKey, vertexId });
+		if (bucket == 0 && _orderTies)
+		{
+			std::push_heap(_buckets[0].begin(), _buckets[0].end(), _HasGreaterTieKey);
+		}
+
+		_size++;
+		_statistics.Pushes++;
+	}
+
+	int GetTopKey()
+	{
+		_Refill();
+		return _FromRadixKey(_lastKey);
+	}
+
+	int Pop()
+	{
+		_Refill();
+
+		if (_orderTies)
+		{
+			std::pop_heap(_buckets[0].begin(), _buckets[0].end(), _HasGreaterTieKey);
+		}
+
+		int vertexId = _buckets[0].back().VertexId;
+		_buckets[0].pop_back();
+		_size--;
+		_statistics.Pops++;
+		return vertexId;
+	}
+
+private:
+	static const int BUCKETS_NUMBER = 33;
+
+	struct Item
+	{
+		uint32_t Key; // Radix key.
+		int TieKey;
+		int VertexId;
+	};
+
+	static bool _HasGreaterTieKey(const Item& left, const Item& right) { return left.TieKey > right.TieKey; }
+
+	// Keys may be negative (e.g. keys of bidirectional A*): flipping the sign bit keeps the order for unsigned keys.
+	static uint32_t _ToRadixKey(int key) { return (uint32_t)key ^ 0x80000000u; }
+	static int _FromRadixKey(uint32_t key) { return (int)(key ^ 0x80000000u); }
+
+	int _BucketIndex(uint32_t key) const
+	{
+		return key == _lastKey ? 0 : 32 - std::countl_zero(key ^ _lastKey);
+	}
+
+	/// <summary>
+	/// Makes sure bucket 0 has items with the smallest key (as a heap of tie keys if ties are ordered).
+	/// </summary>
+	void _Refill()
+	{
+		if (!_buckets[0].empty())
+		{
+			return;
+		}
+
+		int bucket = 1;
+		while (_buckets[bucket].empty())
+		{
+			bucket++;
+		}
+
+		uint32_t minKey = _buckets[bucket][0].Key;
+		for (const Item& item : _buckets[bucket])
+		{
+			minKey = std::min(minKey, item.Key);
+		}
+
+		_lastKey = minKey;
+		for (const Item& item : _buckets[bucket])
+		{
+			_buckets[_BucketIndex(item.Key)].push_back(item);
+		}
+
+		_buckets[bucket].clear();
+
+		if (_orderTies)
+		{
+			std::make_heap(_buckets[0].begin(), _buckets[0].end(), _HasGreaterTieKey);
+		}
+	}
+
+private:
+	std::vector<Item> _buckets[BUCKETS_NUMBER];
+	size_t _size;
+	uint32_t _lastKey;
+	bool _orderTies;
+	QueueStatistics _statistics;
+};
+
+/// <summary>
+/// Dial's bucket queue: circular array of maxKeyStep + 1 buckets, bucket i keeps items with key % buckets number == i.
+/// Since all the keys in the queue are within maxKeyStep from the smallest one, buckets never mix different keys.
+/// O(1) per push and O(maxKeyStep) at worst per pop, so it pays off for small integer weights.
+/// </summary>
+class BucketQueue
+{
+public:
+	BucketQueue() : _size(0), _topKey(0), _isStarted(false), _orderTies(false), _isTopOrdered(false) {}
+
+	void Reset([[maybe_unused]] int verticesNumber, int maxKeyStep, bool orderTies = false)
+	{
+		_buckets.resize(maxKeyStep + 1);
+		for (std::vector<Item>& bucket : _buckets)
+		{
+			bucket.clear();
+		}
+
+		_size = 0;
+		_topKey = 0;
+		_isStarted = false;
+		_orderTies = orderTies;
+		_isTopOrdered = false;
+		_statistics = {};
+	}
+
+	bool IsEmpty() const { return _size == 0; }
+	size_t GetSize() const { return _size; }
+	const QueueStatistics& GetStatistics() const { return _statistics; }
+
+	void Update(int key, int vertexId, int tieKey = 0)
+	{
+		// The first key after Reset. Later the queue may get empty, but keys still may not go below the last popped one.
+		if (!_isStarted)
+		{
+			_topKey = key;
+			_isStarted = true;
+		}
+
+		std::vector<Item>& bucket = _buckets[_BucketIndex(key)];
+		bucket.push_back({ tieKey, vertexId });
+		if (key == _topKey && _isTopOrdered)
+		{
+			std::push_heap(bucket.begin(), bucket.end(), _HasGreaterTieKey);
+		}
+
+		_size++;
+		_statistics.Pushes++;
+	}
+
+	int GetTopKey()
+	{
+		while (_buckets[_BucketIndex(_topKey)].empty())
+		{
+			_topKey++;
+			_isTopOrdered = false;
+		}
+
+		// Only the bucket of the smallest key is kept as a heap of tie keys.
+		if (_orderTies && !_isTopOrdered)
+		{
+			std::vector<Item>& bucket = _buckets[_BucketIndex(_topKey)];
+			std::make_heap(bucket.begin(), bucket.end(), _HasGreaterTieKey);
+			_isTopOrdered = true;
+		}
+
+		return _topKey;
+	}
+
+	int Pop()
+	{
+		std::vector<Item>& bucket = _buckets[_BucketIndex(GetTopKey())];
+		if (_isTopOrdered)
+		{
+			std::pop_heap(bucket.begin(), bucket.end(), _HasGreaterTieKey);
+		}
+
+		int vertexId = bucket.back().VertexId;
+		bucket.pop_back();
+		_size--;
+		_statistics.Pops++;
+		return vertexId;
+	}
+
+private:
+	struct Item
+	{
+		int TieKey;
+		int VertexId;
+	};
+
+	static bool _HasGreaterTieKey(const Item& left, const Item& right) { return left.TieKey > right.TieKey; }
+
+	// Keys may be negative (e.g. keys of bidirectional A*).
+	int _BucketIndex(int key) const
+	{
+		int index = key % (int)_buckets.size();
+		return index < 0 ? index + (int)_buckets.size() : index;
+	}
+
+private:
+	std::vector<std::vector<Item>> _buckets;
+	size_t _size;
+	int _topKey; // Not greater than any key in the queue.
+	bool _isStarted;
+	bool _orderTies;
+	bool _isTopOrdered; // Bucket of _topKey is a heap of tie keys.
+	QueueStatistics _statistics;
+};
+
+#endif
@@ -0,0 +1,82 @@
+#include "searchworkspace.h"
+
+SearchWorkspace::SearchWorkspace() : _generation(0)
+{
+}
+
+/// <summary>
+/// Workspace of the calling thread. Searches running in different threads never share it.
+/// </summary>
+SearchWorkspace& SearchWorkspace::ForCurrentThread()
+{
+	static thread_local SearchWorkspace workspace;
+	return workspace;
+}
+
+/// <summary>
+/// Starts a new search over verticesNumber vertices: all vertices become unvisited.
+/// sidesNumber is 2 for searches that need distances of both forward and backward searches.
+/// </summary>
+void SearchWorkspace::Begin(int verticesNumber, int sidesNumber)
+{
+	for (int side = 0; side < sidesNumber; side++)
+	{
+		if (_stamps[side].size() < (size_t)verticesNumber)
+		{
+			_stamps[side].resize(verticesNumber, 0);
+			_distances[side].resize(verticesNumber);
+			_previous[side].resize(verticesNumber);
+		}
+	}
+
+	_visited[0].Resize(verticesNumber);
+	_visited[1].Resize(verticesNumber);
+
+	++_generation;
+
+	// Once in 4 billion searches stamps of old searches could match again, so really clean them.
+	if (_generation == 0)
+	{
+		for (int side = 0; side < 2; side++)
+		{
+			std::fill(_stamps[side].begin(), _stamps[side].end(), 0);
+		}
+
+		_generation = 1;
+	}
+
+	for (int side = 0; side < 2; side++)
+	{
+		_queues[side].clear();
+		_visited[side].Clear();
+	}
+}
+
+/// <summary>
+/// Starts a search that reads and writes distances and previous vertices right in the arrays (see GetDistances),
+/// as passes over the edge list do: every distance becomes INF and every previous vertex -1. O(V), unlike Begin.
+/// </summary>
+void SearchWorkspace::BeginPlain(int verticesNumber)
+{
+	// Stamps no longer tell anything about the arrays, the next Begin makes all vertices unvisited again.
+	Begin(verticesNumber);
+
+	std::fill(_distances[0].begin(), _distances[0].begin() + verticesNumber, INF);
+	std::fill(_previous[0].begin(), _previous[0].begin() + verticesNumber, -1);
+}
+
+size_t SearchWorkspace::GetMemoryUsage() const
+{
+	size_t memory = 0;
+
+	for (int side = 0; side < 2; side++)
+	{
+		memory += _stamps[side].capacity() * sizeof(uint32_t) +
+			_distances[side].capacity() * sizeof(int32_t) +
+			_previous[side].capacity() * sizeof(int32_t) +
+			_queues[side].capacity() * sizeof(int) +
+			_visited[side].GetMemoryUsage();
+	}
+
+	return memory;
+}
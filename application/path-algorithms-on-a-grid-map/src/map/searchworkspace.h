@@ -0,0 +1,156 @@
+#ifndef SEARCHWORKSPACE_H
+#define SEARCHWORKSPACE_H
+
+#include "common.h"
+#include "searchqueue.h"
+#include <cstdint>
+
+/// <summary>
+/// Bitset of visited vertices. Remembers which words were touched, so clearing costs as much as the search did.
+/// </summary>
+class VisitedSet
+{
+public:
+	void Resize(int verticesNumber)
+	{
+		size_t wordsNumber = ((size_t)verticesNumber + 63) / 64;
+		if (_words.size() < wordsNumber)
+		{
+			_words.resize(wordsNumber, 0);
+		}
+	}
+
+	bool Test(int vertexId) const { return (_words[vertexId >> 6] >> (vertexId & 63)) & 1; }
+
+	void Set(int vertexId)
+	{
+		uint64_t& word = _words[vertexId >> 6];
+		if (word == 0)
+		{
+			_dirtyWords.push_back(vertexId >> 6);
+		}
+
+		word |= (uint64_t)1 << (vertexId & 63);
+	}
+
+	void Clear()
+	{
+		for (int word : _dirtyWords)
+		{
+			_words[word] = 0;
+		}
+
+		_dirtyWords.clear();
+	}
+
+	size_t GetMemoryUsage() const { return _words.capacity() * sizeof(uint64_t) + _dirtyWords.capacity() * sizeof(int); }
+
+private:
+	std::vector<uint64_t> _words;
+	std::vector<int> _dirtyWords;
+};
+
+/// <summary>
+/// Work done by searches: vertices added to the open list (generated), taken from it and expanded,
+/// and expanded once again after a cheaper path to them was found (re-expanded).
+/// </summary>
+struct SearchStatistics
+{
+	uint64_t Generated = 0;
+	uint64_t Expanded = 0;
+	uint64_t Reexpanded = 0;
+
+	// Bellman-Ford over the edge list: passes over all arcs, and searches stopped by a pass that relaxed nothing
+	// (the rest found negative cycles: distances still decreased after V - 1 passes).
+	uint64_t Passes = 0;
+	uint64_t EarlyExits = 0;
+};
+
+/// <summary>
+/// Per-vertex state of a path search (distance and previous vertex), reused between searches.
+/// Arrays are allocated once per thread and map size; a new search invalidates them in O(1)
+/// by increasing the generation, so search cost depends on the explored cells only, not on the map size.
+/// Bidirectional searches keep separate state for side 0 (forward search) and side 1 (backward search).
+/// </summary>
+class SearchWorkspace
+{
+public:
+	SearchWorkspace();
+
+	/// <summary>
+	/// Workspace of the calling thread. Searches running in different threads never share it.
+	/// </summary>
+	static SearchWorkspace& ForCurrentThread();
+
+	/// <summary>
+	/// Starts a new search over verticesNumber vertices: all vertices become unvisited.
+	/// sidesNumber is 2 for searches that need distances of both forward and backward searches.
+	/// </summary>
+	void Begin(int verticesNumber, int sidesNumber = 1);
+
+	/// <summary>
+	/// Starts a search that reads and writes distances and previous vertices right in the arrays (see GetDistances),
+	/// as passes over the edge list do: every distance becomes INF and every previous vertex -1. O(V), unlike Begin.
+	/// </summary>
+	void BeginPlain(int verticesNumber);
+
+	/// <summary>
+	/// Arrays of distances and previous vertices of side 0 by vertex id, valid after BeginPlain.
+	/// </summary>
+	int32_t* GetDistances() { return _distances[0].data(); }
+	int32_t* GetPreviousVertices() { return _previous[0].data(); }
+
+	bool IsVisited(int vertexId, int side = 0) const { return _stamps[side][vertexId] == _generation; }
+
+	/// <summary>
+	/// Distance of the vertex, INF if it is not visited in the current search.
+	/// </summary>
+	int GetDistance(int vertexId, int side = 0) const { return IsVisited(vertexId, side) ? _distances[side][vertexId] : INF; }
+
+	/// <summary>
+	/// Previous vertex on the path, -1 if it is not visited in the current search.
+	/// </summary>
+	int GetPrevious(int vertexId, int side = 0) const { return IsVisited(vertexId, side) ? _previous[side][vertexId] : -1; }
+
+	void Visit(int vertexId, int distance, int previous, int side = 0)
+	{
+		_stamps[side][vertexId] = _generation;
+		_distances[side][vertexId] = distance;
+		_previous[side][vertexId] = previous;
+	}
+
+	/// <summary>
+	/// Scratch buffers for FIFO queues of the searches: 0 for forward search, 1 for backward one.
+	/// </summary>
+	std::vector<int>& GetQueue(int side = 0) { return _queues[side]; }
+
+	/// <summary>
+	/// Visited sets of bidirectional searches: 0 for forward search, 1 for backward one.
+	/// </summary>
+	VisitedSet& GetVisited(int side) { return _visited[side]; }
+
+	/// <summary>
+	/// Operation counters of the queues of all searches run by the thread. Searches add counters of their queues when they finish.
+	/// </summary>
+	QueueStatistics& GetQueueStatistics() { return _queueStatistics; }
+
+	/// <summary>
+	/// Counters of all Dijkstra-like searches run by the thread.
+	/// </summary>
+	SearchStatistics& GetSearchStatistics() { return _searchStatistics; }
+
+	size_t GetMemoryUsage() const;
+
+private:
+	std::vector<uint32_t> _stamps[2];
+	std::vector<int32_t> _distances[2];
+	std::vector<int32_t> _previous[2];
+	std::vector<int> _queues[2];
+	VisitedSet _visited[2];
+	QueueStatistics _queueStatistics;
+	SearchStatistics _searchStatistics;
+
+	uint32_t _generation;
+};
+
+#endif
@@ -0,0 +1,71 @@
+#include "terrain.h"
+
+Terrain::Terrain() : _width(0), _height(0)
+{
+}
+
+/// <summary>
+/// Allocates storage for width x height cells. All cells become blocks.
+/// </summary>
+void Terrain::Reset(int width, int height)
+{
+	_width = width;
+	_height = height;
+
+	size_t size = (size_t)width * (size_t)height;
+	_symbols.Assign(size, BLOCK_CELL);
+	_vertexIds.Assign(size, -1);
+	_costs.Assign(size, 0);
+}
+
+void Terrain::SetCell(int index, char symbol, int vertexId, int cost)
+{
+	_symbols.Set(index, symbol);
+	_vertexIds.Set(index, vertexId);
+	_costs.Set(index, (int8_t)cost);
+}
+
+/// <summary>
+/// Uses external arrays of width x height cells (e.g. from the compiled map) instead of own storage.
+/// </summary>
+void Terrain::Attach(int width, int height, const char* symbols, const int32_t* vertexIds, const int8_t* costs)
+{
+	_width = width;
+	_height = height;
+
+	size_t size = (size_t)width * (size_t)height;
+	_symbols.Attach(symbols, size);
+	_vertexIds.Attach(vertexIds, size);
+	_costs.Attach(costs, size);
+}
+
+size_t Terrain::GetMemoryUsage() const
+{
+	return _symbols.GetMemoryUsage() + _vertexIds.GetMemoryUsage() + _costs.GetMemoryUsage();
+}
+
+/// <summary>
+/// FNV-1a hash of the map size and symbols. Tables precomputed for the terrain are stored with it to detect stale files.
+/// </summary>
+uint64_t Terrain::GetHash() const
+{
+	uint64_t hash = 14695981039346656037ULL;
+	auto add = [&hash](uint8_t byte)
+	{
+		hash ^= byte;
+		hash *= 1099511628211ULL;
+	};
+
+	for (int shift = 0; shift < 32; shift += 8)
+	{
+		add((uint8_t)(_width >> shift));
+		add((uint8_t)(_height >> shift));
+	}
+
+	for (size_t index = 0; index < _symbols.GetSize(); index++)
+	{
+		add((uint8_t)_symbols[index]);
+	}
+
+	return hash;
+}
@@ -0,0 +1,64 @@
+#ifndef TERRAIN_H
+#define TERRAIN_H
+
+#include "common.h"
+#include "FlatArray.h"
+#include <cstdint>
+
+/// <summary>
+/// Flat (structure of arrays) storage of the map cells.
+/// Every cell takes 1 byte of symbol, 4 bytes of vertex id and 1 byte of cost,
+/// and all the arrays are indexed by row * width + column.
+/// </summary>
+class Terrain
+{
+public:
+	Terrain();
+
+	/// <summary>
+	/// Allocates storage for width x height cells. All cells become blocks.
+	/// </summary>
+	void Reset(int width, int height);
+
+	void SetCell(int index, char symbol, int vertexId, int cost);
+
+	/// <summary>
+	/// Uses external arrays of width x height cells (e.g. from the compiled map) instead of own storage.
+	/// </summary>
+	void Attach(int width, int height, const char* symbols, const int32_t* vertexIds, const int8_t* costs);
+
+	/// <summary>
+	/// Memory occupied by the terrain arrays, in bytes.
+	/// </summary>
+	size_t GetMemoryUsage() const;
+
+	/// <summary>
+	/// Hash of the map size and symbols. Tables precomputed for the terrain are stored with it to detect stale files.
+	/// </summary>
+	uint64_t GetHash() const;
+
+	int GetWidth() const { return _width; }
+	int GetHeight() const { return _height; }
+	int GetSize() const { return _width * _height; }
+
+	// Hot accessors are kept in the header, since they are used in the inner loops of every search.
+	int Index(int row, int column) const { return row * _width + column; }
+	char GetSymbol(int index) const { return _symbols[index]; }
+	int GetVertexId(int index) const { return _vertexIds[index]; }
+	int GetCost(int index) const { return _costs[index]; }
+
+	// Raw arrays, e.g. to write them into the compiled map.
+	const char* GetSymbols() const { return _symbols.GetData(); }
+	const int32_t* GetVertexIds() const { return _vertexIds.GetData(); }
+	const int8_t* GetCosts() const { return _costs.GetData(); }
+
+private:
+	int _width;
+	int _height;
+
+	FlatArray<char> _symbols;      // Cell symbol as it is written in the map file.
+	FlatArray<int32_t> _vertexIds; // Graph vertex id of the cell, or -1 for non-moveable cells.
+	FlatArray<int8_t> _costs;      // Cost to step into the cell.
+};
+
+#endif
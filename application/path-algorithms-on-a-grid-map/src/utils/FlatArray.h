@@ -0,0 +1,66 @@
+#pragma once
+#ifndef __FlatArray_h__
+#define __FlatArray_h__
+
+#include <cstddef>
+#include <vector>
+
+/// <summary>
+/// Flat array of T that either owns its storage (filled while map is parsed) or refers to
+/// external memory (e.g. section of a memory mapped compiled map). Reads are the same in both cases.
+/// </summary>
+template <typename T>
+class FlatArray
+{
+public:
+	FlatArray() : _data(nullptr), _size(0) {}
+	FlatArray(size_t size, const T& value) : _owned(size, value) { _Sync(); }
+
+	FlatArray(const FlatArray&) = delete;
+	FlatArray& operator=(const FlatArray&) = delete;
+
+	void Assign(size_t size, const T& value) { _owned.assign(size, value); _Sync(); }
+	void Reserve(size_t size) { _owned.reserve(size); _Sync(); }
+	void Clear() { _owned.clear(); _Sync(); }
+	void ShrinkToFit() { _owned.shrink_to_fit(); _Sync(); }
+	void PushBack(const T& value) { _owned.push_back(value); _Sync(); }
+
+	/// <summary>
+	/// Changes owned element. Must not be called for attached arrays.
+	/// </summary>
+	void Set(size_t index, const T& value) { _owned[index] = value; }
+
+	/// <summary>
+	/// Drops owned storage and refers to size elements at data. Memory must outlive the array.
+	/// </summary>
+	void Attach(const T* data, size_t size)
+	{
+		_owned.clear();
+		_owned.shrink_to_fit();
+		_data = data;
+		_size = size;
+	}
+
+	const T& operator[](size_t index) const { return _data[index]; }
+	const T* GetData() const { return _data; }
+	size_t GetSize() const { return _size; }
+
+	/// <summary>
+	/// Heap memory owned by the array, in bytes. Attached arrays own nothing.
+	/// </summary>
+	size_t GetMemoryUsage() const { return _owned.capacity() * sizeof(T); }
+
+private:
+	void _Sync()
+	{
+		_data = _owned.data();
+		_size = _owned.size();
+	}
+
+private:
+	std::vector<T> _owned;
+	const T* _data;
+	size_t _size;
+};
+
+#endif __FlatArray_h__
@@ -0,0 +1,39 @@
+#pragma once
+#ifndef __MappedFile_h__
+#define __MappedFile_h__
+
+#include <cstddef>
+#include <string>
+
+/// <summary>
+/// Read-only memory mapped file. Content is paged in by the OS on first access, no copies are made.
+/// </summary>
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool Open(const std::string& filepath);
+	void Close();
+
+	bool IsOpen() const { return _data != nullptr; }
+	const char* GetData() const { return _data; }
+	size_t GetSize() const { return _size; }
+
+private:
+	const char* _data;
+	size_t _size;
+
+#ifdef _WIN32
+	void* _file;
+	void* _mapping;
+#else
+	int _file;
+#endif
+};
+
+#endif __MappedFile_h__